@@ -0,0 +1,155 @@
+//
+//  cache.c
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+/*
+ hq2x的邻域缓存。
+ 
+ DMG画面最多只有4种颜色，把每个像素映射为2位颜色编号后，3x3邻域就是一个
+ 18位的键，而hq2x的输出2x2块只取决于这9个像素，所以可以按键记住输出块，
+ 之后同样的邻域直接拷贝。未命中时把邻域当成一张3x3的小图交给hq2x_32_rb_rows
+ 算中心像素，保证结果与普通路径逐位一致。
+ 
+ 颜色表跨帧保留，只有出现新颜色且表已满时才清空缓存。
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "hqx.h"
+
+#define KEYS    (1 << 18)
+
+static uint32_t (*blocks)[4];   // 每个键的2x2输出块
+static uint32_t valid[KEYS / 32];
+static uint32_t palette[4];
+static int paletteSize;
+static uint8_t *idx;            // 当前帧的颜色编号
+static int idxSize;
+
+// 颜色超过4种返回0
+static int collect(uint32_t *sp, uint32_t srb, int x0, int y0, int x1, int y1, uint32_t *seen)
+{
+    int n = 0;
+    int i, j, k;
+    
+    for (j = y0; j < y1; j++) {
+        uint32_t *row = (uint32_t *)((uint8_t *)sp + j * srb);
+        for (i = x0; i < x1; i++) {
+            for (k = 0; k < n && seen[k] != row[i]; k++);
+            if (k == n) {
+                if (n == 4) return 0;
+                seen[n++] = row[i];
+            }
+        }
+    }
+    return n;
+}
+
+// 把[x0,x1)x[y0,y1)映射到颜色编号，颜色超过4种返回0
+static int mapFrame(uint32_t *sp, uint32_t srb, int Xres, int Yres, int x0, int y0, int x1, int y1)
+{
+    int i, j, k;
+    
+    if (idxSize < Xres * Yres) {
+        uint8_t *p = realloc(idx, Xres * Yres);
+        if (!p) return 0;
+        idx = p;
+        idxSize = Xres * Yres;
+    }
+    
+    for (j = y0; j < y1; j++) {
+        uint32_t *row = (uint32_t *)((uint8_t *)sp + j * srb);
+        uint8_t *out = idx + j * Xres;
+        uint32_t last = palette[0];
+        int lastIdx = paletteSize ? 0 : -1;
+        
+        for (i = x0; i < x1; i++) {
+            // 相邻像素大多同色
+            if (row[i] == last && lastIdx >= 0) {
+                out[i] = lastIdx;
+                continue;
+            }
+            for (k = 0; k < paletteSize && palette[k] != row[i]; k++);
+            if (k == paletteSize) {
+                if (paletteSize == 4) {
+                    // 换颜色表，旧的缓存全部作废
+                    uint32_t seen[4];
+                    int n = collect(sp, srb, x0, y0, x1, y1, seen);
+                    if (!n) return 0;
+                    memcpy(palette, seen, n * sizeof(uint32_t));
+                    paletteSize = n;
+                    memset(valid, 0, sizeof(valid));
+                    return mapFrame(sp, srb, Xres, Yres, x0, y0, x1, y1);
+                }
+                palette[paletteSize++] = row[i];
+            }
+            out[i] = lastIdx = k;
+            last = row[i];
+        }
+    }
+    return 1;
+}
+
+static void computeBlock(int key, uint32_t *block)
+{
+    uint32_t src[9], dst[36];
+    int k;
+    
+    // 键按列排列，每列6位，列内从上到下
+    for (k = 0; k < 9; k++) src[k] = palette[(key >> ((k % 3) * 6 + (k / 3) * 2)) & 3];
+    hq2x_32_rb_rows(src, 3 * 4, dst, 6 * 4, 3, 3, 1, 2);
+    block[0] = dst[2 * 6 + 2];
+    block[1] = dst[2 * 6 + 3];
+    block[2] = dst[3 * 6 + 2];
+    block[3] = dst[3 * 6 + 3];
+}
+
+HQX_API int HQX_CALLCONV hq2x_32_rb_cached_rect( uint32_t * sp, uint32_t srb, uint32_t * dp, uint32_t drb, int Xres, int Yres, int x0, int y0, int x1, int y1 )
+{
+    int i, j;
+    
+    if (x0 >= x1 || y0 >= y1) return 1;
+    if (!blocks && !(blocks = malloc(sizeof(*blocks) * KEYS))) return 0;
+    // 只映射区域加一圈邻居
+    if (!mapFrame(sp, srb, Xres, Yres, x0 > 0 ? x0 - 1 : 0, y0 > 0 ? y0 - 1 : 0,
+                  x1 < Xres ? x1 + 1 : Xres, y1 < Yres ? y1 + 1 : Yres)) return 0;
+    
+    for (j = y0; j < y1; j++) {
+        const uint8_t *p = idx + (j > 0 ? j - 1 : j) * Xres;
+        const uint8_t *c = idx + j * Xres;
+        const uint8_t *n = idx + (j < Yres - 1 ? j + 1 : j) * Xres;
+        uint32_t *d0 = (uint32_t *)((uint8_t *)dp + j * 2 * drb);
+        uint32_t *d1 = (uint32_t *)((uint8_t *)d0 + drb);
+        
+        int l = x0 > 0 ? x0 - 1 : x0;
+        int key = (p[l] | c[l] << 2 | n[l] << 4) << 6 | (p[x0] | c[x0] << 2 | n[x0] << 4) << 12;
+        
+        for (i = x0; i < x1; i++) {
+            int r = i < Xres - 1 ? i + 1 : i;
+            uint32_t *block;
+            
+            key = (key >> 6) | (p[r] | c[r] << 2 | n[r] << 4) << 12;
+            block = blocks[key];
+            
+            if (!(valid[key >> 5] & (1u << (key & 31)))) {
+                computeBlock(key, block);
+                valid[key >> 5] |= 1u << (key & 31);
+            }
+            d0[i * 2] = block[0];
+            d0[i * 2 + 1] = block[1];
+            d1[i * 2] = block[2];
+            d1[i * 2 + 1] = block[3];
+        }
+    }
+    return 1;
+}
+
+HQX_API int HQX_CALLCONV hq2x_32_rb_cached( uint32_t * sp, uint32_t srb, uint32_t * dp, uint32_t drb, int Xres, int Yres )
+{
+    return hq2x_32_rb_cached_rect(sp, srb, dp, drb, Xres, Yres, 0, 0, Xres, Yres);
+}
@@ -25,6 +25,21 @@
 #include <stdlib.h>
 #include <stdint.h>
 
+/* SIMD paths; define HQX_NO_SIMD to force the scalar reference code */
+#if !defined(HQX_NO_SIMD)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define HQX_AVX2 1
+#endif
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#define HQX_SSE41 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HQX_NEON 1
+#endif
+#endif
+
 #define MASK_2     0x0000FF00
 #define MASK_13    0x00FF00FF
 #define MASK_RGB   0x00FFFFFF
@@ -58,24 +73,60 @@ static inline int Diff(uint32_t c1, uint32_t c2)
     return yuv_diff(rgb_to_yuv(c1), rgb_to_yuv(c2));
 }
 
+/* Difference pattern (bit k set when neighbour k differs from the centre, in
+ * w1,w2,w3,w4,w6,w7,w8,w9 order) for pixels [x0, x1) of a row, stored at
+ * out[x0..x1). prev/cur/next are the rows above, at and below, already clamped
+ * at the image edges. */
+void hqx_row_patterns(const uint32_t *prev, const uint32_t *cur, const uint32_t *next, uint8_t *out, int width, int x0, int x1);
+
 /* Interpolate functions */
 static inline uint32_t Interpolate_2(uint32_t c1, int w1, uint32_t c2, int w2, int s)
 {
     if (c1 == c2) {
         return c1;
     }
+#if defined(HQX_SSE41)
+    /* Weights sum to 1 << s, so each channel is (c1*w1 + c2*w2) >> s in 16-bit lanes */
+    __m128i a = _mm_cvtepu8_epi16(_mm_cvtsi32_si128((int)c1));
+    __m128i b = _mm_cvtepu8_epi16(_mm_cvtsi32_si128((int)c2));
+    __m128i r = _mm_add_epi16(_mm_mullo_epi16(a, _mm_set1_epi16(w1)), _mm_mullo_epi16(b, _mm_set1_epi16(w2)));
+    r = _mm_srl_epi16(r, _mm_cvtsi32_si128(s));
+    return (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(r, r));
+#elif defined(HQX_NEON)
+    uint16x8_t r = vmull_u8(vreinterpret_u8_u32(vdup_n_u32(c1)), vdup_n_u8(w1));
+    r = vmlal_u8(r, vreinterpret_u8_u32(vdup_n_u32(c2)), vdup_n_u8(w2));
+    r = vshlq_u16(r, vdupq_n_s16(-s));
+    return vget_lane_u32(vreinterpret_u32_u8(vmovn_u16(r)), 0);
+#else
     return
         (((((c1 & MASK_ALPHA) >> 24) * w1 + ((c2 & MASK_ALPHA) >> 24) * w2) << (24-s)) & MASK_ALPHA) +
         ((((c1 & MASK_2) * w1 + (c2 & MASK_2) * w2) >> s) & MASK_2)	+
         ((((c1 & MASK_13) * w1 + (c2 & MASK_13) * w2) >> s) & MASK_13);
+#endif
 }
 
 static inline uint32_t Interpolate_3(uint32_t c1, int w1, uint32_t c2, int w2, uint32_t c3, int w3, int s)
 {
+#if defined(HQX_SSE41)
+    __m128i a = _mm_cvtepu8_epi16(_mm_cvtsi32_si128((int)c1));
+    __m128i b = _mm_cvtepu8_epi16(_mm_cvtsi32_si128((int)c2));
+    __m128i c = _mm_cvtepu8_epi16(_mm_cvtsi32_si128((int)c3));
+    __m128i r = _mm_add_epi16(_mm_mullo_epi16(a, _mm_set1_epi16(w1)), _mm_mullo_epi16(b, _mm_set1_epi16(w2)));
+    r = _mm_add_epi16(r, _mm_mullo_epi16(c, _mm_set1_epi16(w3)));
+    r = _mm_srl_epi16(r, _mm_cvtsi32_si128(s));
+    return (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(r, r));
+#elif defined(HQX_NEON)
+    uint16x8_t r = vmull_u8(vreinterpret_u8_u32(vdup_n_u32(c1)), vdup_n_u8(w1));
+    r = vmlal_u8(r, vreinterpret_u8_u32(vdup_n_u32(c2)), vdup_n_u8(w2));
+    r = vmlal_u8(r, vreinterpret_u8_u32(vdup_n_u32(c3)), vdup_n_u8(w3));
+    r = vshlq_u16(r, vdupq_n_s16(-s));
+    return vget_lane_u32(vreinterpret_u32_u8(vmovn_u16(r)), 0);
+#else
     return
         (((((c1 & MASK_ALPHA) >> 24) * w1 + ((c2 & MASK_ALPHA) >> 24) * w2 + ((c3 & MASK_ALPHA) >> 24) * w3) << (24-s)) & MASK_ALPHA) +
         ((((c1 & MASK_2) * w1 + (c2 & MASK_2) * w2 + (c3 & MASK_2) * w3) >> s) & MASK_2) +
         ((((c1 & MASK_13) * w1 + (c2 & MASK_13) * w2 + (c3 & MASK_13) * w3) >> s) & MASK_13);
+#endif
 }
 
 static inline void Interp1(uint32_t * pc, uint32_t c1, uint32_t c2)
@@ -163,16 +163,16 @@
 #define PIXEL33_81    Interp8(dp+dpL+dpL+dpL+3, w[5], w[6]);
 #define PIXEL33_82    Interp8(dp+dpL+dpL+dpL+3, w[5], w[8]);
 
-HQX_API void HQX_CALLCONV hq4x_32_rb( uint32_t * sp, uint32_t srb, uint32_t * dp, uint32_t drb, int Xres, int Yres )
+HQX_API void HQX_CALLCONV hq4x_32_rb_rect( uint32_t * sp, uint32_t srb, uint32_t * dp, uint32_t drb, int Xres, int Yres, int x0, int y0, int x1, int y1 )
 {
-    int  i, j, k;
+    int  i, j;
     int  prevline, nextline;
     uint32_t w[10];
+    uint8_t  patterns[Xres];
     int dpL = (drb >> 2);
     int spL = (srb >> 2);
-    uint8_t *sRowP = (uint8_t *) sp;
-    uint8_t *dRowP = (uint8_t *) dp;
-    uint32_t yuv1, yuv2;
+    uint8_t *sRowP = (uint8_t *) sp + y0 * srb;
+    uint8_t *dRowP = (uint8_t *) dp + y0 * drb * 4;
 
     //   +----+----+----+
     //   |    |    |    |
@@ -185,12 +185,21 @@ HQX_API void HQX_CALLCONV hq4x_32_rb( uint32_t * sp, uint32_t srb, uint32_t * dp
     //   | w7 | w8 | w9 |
     //   +----+----+----+
 
-    for (j=0; j<Yres; j++)
+    sp = (uint32_t *) sRowP;
+    dp = (uint32_t *) dRowP;
+
+    for (j=y0; j<y1; j++)
     {
         if (j>0)      prevline = -spL; else prevline = 0;
         if (j<Yres-1) nextline =  spL; else nextline = 0;
 
-        for (i=0; i<Xres; i++)
+        /* Difference pattern of every pixel in the row, computed up front (SIMD when available) */
+        hqx_row_patterns(sp + prevline, sp, sp + nextline, patterns, Xres, x0, x1);
+
+        sp += x0;
+        dp += x0 * 4;
+
+        for (i=x0; i<x1; i++)
         {
             w[2] = *(sp + prevline);
             w[5] = *sp;
@@ -222,23 +231,7 @@ HQX_API void HQX_CALLCONV hq4x_32_rb( uint32_t * sp, uint32_t srb, uint32_t * dp
                 w[9] = w[8];
             }
 
-            int pattern = 0;
-            int flag = 1;
-
-            yuv1 = rgb_to_yuv(w[5]);
-
-            for (k=1; k<=9; k++)
-            {
-                if (k==5) continue;
-
-                if ( w[k] != w[5] )
-                {
-                    yuv2 = rgb_to_yuv(w[k]);
-                    if (yuv_diff(yuv1, yuv2))
-                        pattern |= flag;
-                }
-                flag <<= 1;
-            }
+            int pattern = patterns[i];
 
             switch (pattern)
             {
@@ -5226,6 +5219,16 @@ HQX_API void HQX_CALLCONV hq4x_32_rb( uint32_t * sp, uint32_t srb, uint32_t * dp
     }
 }
 
+HQX_API void HQX_CALLCONV hq4x_32_rb_rows( uint32_t * sp, uint32_t srb, uint32_t * dp, uint32_t drb, int Xres, int Yres, int y0, int y1 )
+{
+    hq4x_32_rb_rect(sp, srb, dp, drb, Xres, Yres, 0, y0, Xres, y1);
+}
+
+HQX_API void HQX_CALLCONV hq4x_32_rb( uint32_t * sp, uint32_t srb, uint32_t * dp, uint32_t drb, int Xres, int Yres )
+{
+    hq4x_32_rb_rect(sp, srb, dp, drb, Xres, Yres, 0, 0, Xres, Yres);
+}
+
 HQX_API void HQX_CALLCONV hq4x_32( uint32_t * sp, uint32_t * dp, int Xres, int Yres )
 {
     uint32_t rowBytesL = Xres * 4;
@@ -52,4 +52,27 @@ HQX_API void HQX_CALLCONV hq2x_32_rb( uint32_t * src, uint32_t src_rowBytes, uin
 HQX_API void HQX_CALLCONV hq3x_32_rb( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height );
 HQX_API void HQX_CALLCONV hq4x_32_rb( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height );
 
+/* Scale only source rows [y0, y1) of a width x height image; src/dest still point at row 0 */
+HQX_API void HQX_CALLCONV hq2x_32_rb_rows( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height, int y0, int y1 );
+HQX_API void HQX_CALLCONV hq3x_32_rb_rows( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height, int y0, int y1 );
+HQX_API void HQX_CALLCONV hq4x_32_rb_rows( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height, int y0, int y1 );
+
+/* Scale only source pixels [x0, x1) x [y0, y1); neighbours outside the rect are still read from src.
+ * A changed source pixel affects its 3x3 neighbourhood, so grow dirty rects by one pixel (clamped) first. */
+HQX_API void HQX_CALLCONV hq2x_32_rb_rect( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height, int x0, int y0, int x1, int y1 );
+HQX_API void HQX_CALLCONV hq3x_32_rb_rect( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height, int x0, int y0, int x1, int y1 );
+HQX_API void HQX_CALLCONV hq4x_32_rb_rect( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height, int x0, int y0, int x1, int y1 );
+
+/* 0 runs the scalar reference code even in a SIMD build (for checking); not while a scale is running */
+HQX_API void HQX_CALLCONV hqxSetSimd( int on );
+
+/* Band-parallel driver: splits the rows across a pool of hqxSetThreads() threads */
+HQX_API void HQX_CALLCONV hqxSetThreads( int threads );
+HQX_API void HQX_CALLCONV hqx_32_rb_parallel( int scale, uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height );
+HQX_API void HQX_CALLCONV hqx_32_rb_parallel_rect( int scale, uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height, int x0, int y0, int x1, int y1 );
+
+/* hq2x memoized per 3x3 neighbourhood; returns 0 (and writes nothing) if the frame has more than 4 colours */
+HQX_API int HQX_CALLCONV hq2x_32_rb_cached( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height );
+HQX_API int HQX_CALLCONV hq2x_32_rb_cached_rect( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height, int x0, int y0, int x1, int y1 );
+
 #endif
@@ -0,0 +1,148 @@
+//
+//  parallel.c
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+/*
+ HQX按行带并行：每个输出行只依赖上中下三行源像素，所以把源图按行切成若干
+ 水平带，交给常驻线程池各自调用hqNx_32_rb_rows，调用线程自己也领带干活，
+ 全部完成后才返回。
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include "hqx.h"
+
+#define HQX_MAX_THREADS 8
+
+struct job {
+    int scale;
+    uint32_t *sp;
+    uint32_t srb;
+    uint32_t *dp;
+    uint32_t drb;
+    int width;
+    int height;
+    int x0, y0, x1, y1;
+};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done = PTHREAD_COND_INITIALIZER;
+static int threads = 1;     // 包括调用线程
+static int workers;         // 已启动的工作线程，只增不减
+static struct job job;
+static int active;          // 这个任务参与的工作线程数，编号小于它的才领带
+static int bands, nextBand, pending;
+
+static void runRows(const struct job *j, int y0, int y1)
+{
+    switch (j->scale) {
+        case 2:
+            hq2x_32_rb_rect(j->sp, j->srb, j->dp, j->drb, j->width, j->height, j->x0, y0, j->x1, y1);
+            break;
+        case 3:
+            hq3x_32_rb_rect(j->sp, j->srb, j->dp, j->drb, j->width, j->height, j->x0, y0, j->x1, y1);
+            break;
+        case 4:
+            hq4x_32_rb_rect(j->sp, j->srb, j->dp, j->drb, j->width, j->height, j->x0, y0, j->x1, y1);
+            break;
+    }
+}
+
+static void runBand(int b)
+{
+    int rows = job.y1 - job.y0;
+    
+    runRows(&job, job.y0 + rows * b / bands, job.y0 + rows * (b + 1) / bands);
+}
+
+// 领取并完成带，直到没有剩余；进入和返回时都持有lock
+static void drain(void)
+{
+    while (nextBand < bands) {
+        int b = nextBand++;
+        pthread_mutex_unlock(&lock);
+        runBand(b);
+        pthread_mutex_lock(&lock);
+        if (--pending == 0) pthread_cond_signal(&done);
+    }
+}
+
+static void* worker(void *arg)
+{
+    int id = (int)(intptr_t)arg;
+    
+    pthread_mutex_lock(&lock);
+    for (;;) {
+        // 线程数调小后多出来的线程一直睡着
+        while (nextBand >= bands || id >= active) pthread_cond_wait(&work, &lock);
+        drain();
+    }
+    return NULL;
+}
+
+HQX_API void HQX_CALLCONV hqxSetThreads(int n)
+{
+    if (n < 1) n = 1;
+    if (n > HQX_MAX_THREADS) n = HQX_MAX_THREADS;
+    
+    pthread_mutex_lock(&lock);
+    threads = n;
+    while (workers < threads - 1) {
+        pthread_t t;
+        if (pthread_create(&t, NULL, worker, (void *)(intptr_t)workers) != 0) break;
+        pthread_detach(t);
+        workers++;
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+HQX_API void HQX_CALLCONV hqx_32_rb_parallel_rect(int scale, uint32_t *sp, uint32_t srb, uint32_t *dp, uint32_t drb, int Xres, int Yres, int x0, int y0, int x1, int y1)
+{
+    if (x0 >= x1 || y0 >= y1) return;
+    
+    pthread_mutex_lock(&lock);
+    
+    if (threads == 1) {
+        // 串行：不唤醒任何工作线程
+        struct job serial = { scale, sp, srb, dp, drb, Xres, Yres, x0, y0, x1, y1 };
+        pthread_mutex_unlock(&lock);
+        runRows(&serial, y0, y1);
+        return;
+    }
+    
+    job.scale = scale;
+    job.sp = sp;
+    job.srb = srb;
+    job.dp = dp;
+    job.drb = drb;
+    job.width = Xres;
+    job.height = Yres;
+    job.x0 = x0;
+    job.y0 = y0;
+    job.x1 = x1;
+    job.y1 = y1;
+    
+    // 每个线程两条带，负载不均时可以互相补位
+    active = threads - 1;
+    if (active > workers) active = workers;
+    bands = (active + 1) * 2;
+    if (bands > y1 - y0) bands = y1 - y0;
+    nextBand = 0;
+    pending = bands;
+    if (active) pthread_cond_broadcast(&work);
+    
+    drain();
+    while (pending) pthread_cond_wait(&done, &lock);
+    
+    pthread_mutex_unlock(&lock);
+}
+
+HQX_API void HQX_CALLCONV hqx_32_rb_parallel(int scale, uint32_t *sp, uint32_t srb, uint32_t *dp, uint32_t drb, int Xres, int Yres)
+{
+    hqx_32_rb_parallel_rect(scale, sp, srb, dp, drb, Xres, Yres, 0, 0, Xres, Yres);
+}
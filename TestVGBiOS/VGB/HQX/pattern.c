@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2003 Maxim Stepin ( maxst@hiend3d.com )
+ *
+ * Copyright (C) 2010 Cameron Zemek ( grom@zeminvaders.net)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "common.h"
+#include "hqx.h"
+
+/* Cleared by hqxSetSimd(0) to run the scalar reference code in a SIMD build */
+static int simd = 1;
+
+HQX_API void HQX_CALLCONV hqxSetSimd(int on)
+{
+    simd = on;
+}
+
+/* Convert pixels [x0, x1) of a row to YUV plus one neighbour on each side,
+ * replicating the edge pixel where the neighbour falls outside the image */
+static inline void yuv_row(const uint32_t *src, uint32_t *yuv, int width, int x0, int x1)
+{
+    int i;
+
+    for (i = x0; i < x1; i++)
+        yuv[i-x0+1] = rgb_to_yuv(src[i]);
+    yuv[0] = rgb_to_yuv(src[x0 > 0 ? x0-1 : x0]);
+    yuv[x1-x0+1] = rgb_to_yuv(src[x1 < width ? x1 : x1-1]);
+}
+
+/* Reference path: same lookups as the original per-pixel loop */
+static inline int scalar_pattern(const uint32_t *prev, const uint32_t *cur, const uint32_t *next, int i, int width)
+{
+    int l = i > 0 ? i - 1 : i;
+    int r = i < width - 1 ? i + 1 : i;
+    uint32_t w[8] = { prev[l], prev[i], prev[r], cur[l], cur[r], next[l], next[i], next[r] };
+    uint32_t yuv1 = rgb_to_yuv(cur[i]);
+    int pattern = 0;
+    int k;
+
+    for (k = 0; k < 8; k++)
+    {
+        if (w[k] != cur[i] && yuv_diff(yuv1, rgb_to_yuv(w[k])))
+            pattern |= 1 << k;
+    }
+    return pattern;
+}
+
+#if defined(HQX_AVX2)
+static inline __m256i diff8(__m256i c, const uint32_t *p, int bit)
+{
+    __m256i n = _mm256_loadu_si256((const __m256i *)p);
+    __m256i y = _mm256_abs_epi32(_mm256_sub_epi32(_mm256_and_si256(c, _mm256_set1_epi32(Ymask)), _mm256_and_si256(n, _mm256_set1_epi32(Ymask))));
+    __m256i u = _mm256_abs_epi32(_mm256_sub_epi32(_mm256_and_si256(c, _mm256_set1_epi32(Umask)), _mm256_and_si256(n, _mm256_set1_epi32(Umask))));
+    __m256i v = _mm256_abs_epi32(_mm256_sub_epi32(_mm256_and_si256(c, _mm256_set1_epi32(Vmask)), _mm256_and_si256(n, _mm256_set1_epi32(Vmask))));
+    __m256i d = _mm256_or_si256(_mm256_cmpgt_epi32(y, _mm256_set1_epi32(trY)),
+                _mm256_or_si256(_mm256_cmpgt_epi32(u, _mm256_set1_epi32(trU)), _mm256_cmpgt_epi32(v, _mm256_set1_epi32(trV))));
+    return _mm256_and_si256(d, _mm256_set1_epi32(bit));
+}
+#endif
+
+#if defined(HQX_SSE41)
+static inline __m128i diff4(__m128i c, const uint32_t *p, int bit)
+{
+    __m128i n = _mm_loadu_si128((const __m128i *)p);
+    __m128i y = _mm_abs_epi32(_mm_sub_epi32(_mm_and_si128(c, _mm_set1_epi32(Ymask)), _mm_and_si128(n, _mm_set1_epi32(Ymask))));
+    __m128i u = _mm_abs_epi32(_mm_sub_epi32(_mm_and_si128(c, _mm_set1_epi32(Umask)), _mm_and_si128(n, _mm_set1_epi32(Umask))));
+    __m128i v = _mm_abs_epi32(_mm_sub_epi32(_mm_and_si128(c, _mm_set1_epi32(Vmask)), _mm_and_si128(n, _mm_set1_epi32(Vmask))));
+    __m128i d = _mm_or_si128(_mm_cmpgt_epi32(y, _mm_set1_epi32(trY)),
+                _mm_or_si128(_mm_cmpgt_epi32(u, _mm_set1_epi32(trU)), _mm_cmpgt_epi32(v, _mm_set1_epi32(trV))));
+    return _mm_and_si128(d, _mm_set1_epi32(bit));
+}
+#elif defined(HQX_NEON)
+static inline uint32x4_t diff4(uint32x4_t c, const uint32_t *p, uint32_t bit)
+{
+    uint32x4_t n = vld1q_u32(p);
+    uint32x4_t y = vabdq_u32(vandq_u32(c, vdupq_n_u32(Ymask)), vandq_u32(n, vdupq_n_u32(Ymask)));
+    uint32x4_t u = vabdq_u32(vandq_u32(c, vdupq_n_u32(Umask)), vandq_u32(n, vdupq_n_u32(Umask)));
+    uint32x4_t v = vabdq_u32(vandq_u32(c, vdupq_n_u32(Vmask)), vandq_u32(n, vdupq_n_u32(Vmask)));
+    uint32x4_t d = vorrq_u32(vcgtq_u32(y, vdupq_n_u32(trY)),
+                   vorrq_u32(vcgtq_u32(u, vdupq_n_u32(trU)), vcgtq_u32(v, vdupq_n_u32(trV))));
+    return vandq_u32(d, vdupq_n_u32(bit));
+}
+#endif
+
+#if defined(HQX_AVX2) || defined(HQX_SSE41) || defined(HQX_NEON)
+/* Returns how many pixels from x0 were done; the scalar loop finishes the row */
+static int simd_patterns(const uint32_t *prev, const uint32_t *cur, const uint32_t *next, uint8_t *out, int width, int x0, int x1)
+{
+    int i = 0;
+    int n = x1 - x0;
+    uint32_t yp[n+2], yc[n+2], yn[n+2];
+
+    yuv_row(prev, yp, width, x0, x1);
+    yuv_row(cur, yc, width, x0, x1);
+    yuv_row(next, yn, width, x0, x1);
+#if defined(HQX_AVX2)
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i c = _mm256_loadu_si256((const __m256i *)(yc + i + 1));
+        __m256i p = diff8(c, yp + i, 1);
+        p = _mm256_or_si256(p, diff8(c, yp + i + 1, 2));
+        p = _mm256_or_si256(p, diff8(c, yp + i + 2, 4));
+        p = _mm256_or_si256(p, diff8(c, yc + i,     8));
+        p = _mm256_or_si256(p, diff8(c, yc + i + 2, 16));
+        p = _mm256_or_si256(p, diff8(c, yn + i,     32));
+        p = _mm256_or_si256(p, diff8(c, yn + i + 1, 64));
+        p = _mm256_or_si256(p, diff8(c, yn + i + 2, 128));
+        __m128i w = _mm_packus_epi32(_mm256_castsi256_si128(p), _mm256_extracti128_si256(p, 1));
+        _mm_storel_epi64((__m128i *)(out + i), _mm_packus_epi16(w, w));
+    }
+#endif
+#if defined(HQX_SSE41)
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i c = _mm_loadu_si128((const __m128i *)(yc + i + 1));
+        __m128i p = diff4(c, yp + i, 1);
+        p = _mm_or_si128(p, diff4(c, yp + i + 1, 2));
+        p = _mm_or_si128(p, diff4(c, yp + i + 2, 4));
+        p = _mm_or_si128(p, diff4(c, yc + i,     8));
+        p = _mm_or_si128(p, diff4(c, yc + i + 2, 16));
+        p = _mm_or_si128(p, diff4(c, yn + i,     32));
+        p = _mm_or_si128(p, diff4(c, yn + i + 1, 64));
+        p = _mm_or_si128(p, diff4(c, yn + i + 2, 128));
+        p = _mm_packus_epi32(p, p);
+        uint32_t b = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(p, p));
+        memcpy(out + i, &b, 4);
+    }
+#elif defined(HQX_NEON)
+    for (; i + 4 <= n; i += 4)
+    {
+        uint32x4_t c = vld1q_u32(yc + i + 1);
+        uint32x4_t p = diff4(c, yp + i, 1);
+        p = vorrq_u32(p, diff4(c, yp + i + 1, 2));
+        p = vorrq_u32(p, diff4(c, yp + i + 2, 4));
+        p = vorrq_u32(p, diff4(c, yc + i,     8));
+        p = vorrq_u32(p, diff4(c, yc + i + 2, 16));
+        p = vorrq_u32(p, diff4(c, yn + i,     32));
+        p = vorrq_u32(p, diff4(c, yn + i + 1, 64));
+        p = vorrq_u32(p, diff4(c, yn + i + 2, 128));
+        uint16x4_t h = vmovn_u32(p);
+        uint8x8_t b = vmovn_u16(vcombine_u16(h, h));
+        vst1_lane_u32((uint32_t *)(out + i), vreinterpret_u32_u8(b), 0);
+    }
+#endif
+    return i;
+}
+#endif
+
+void hqx_row_patterns(const uint32_t *prev, const uint32_t *cur, const uint32_t *next, uint8_t *out, int width, int x0, int x1)
+{
+    int i = 0;
+    int n = x1 - x0;
+
+    out += x0;
+#if defined(HQX_AVX2) || defined(HQX_SSE41) || defined(HQX_NEON)
+    if (simd)
+        i = simd_patterns(prev, cur, next, out, width, x0, x1);
+#endif
+    for (; i < n; i++)
+        out[i] = scalar_pattern(prev, cur, next, x0 + i, width);
+}
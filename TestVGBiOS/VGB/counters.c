@@ -0,0 +1,61 @@
+//
+//  counters.c
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+#include "counters.h"
+
+#include <string.h>
+#include <time.h>
+
+#include "pace.h"
+
+const char *counterRegionName(int region)
+{
+    static const char *const names[COUNTER_REGIONS] = { "ROM0", "ROMX", "VRAM", "SRAM", "WRAM", "ECHO", "OAM", "IO", "HRAM" };
+
+    return region >= 0 && region < COUNTER_REGIONS ? names[region] : "?";
+}
+
+#ifdef VGB_STATS
+
+struct counters counters;
+
+double countersNow(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int countersGet(struct counters *c)
+{
+    struct paceStats pace;
+
+    *c = counters;
+    paceGetStats(&pace);
+    c->sleepSeconds = pace.sleepMs / 1e3;
+    return 0;
+}
+
+void countersReset(void)
+{
+    memset(&counters, 0, sizeof(counters));
+}
+
+#else
+
+int countersGet(struct counters *c)
+{
+    memset(c, 0, sizeof(*c));
+    return -1;
+}
+
+void countersReset(void)
+{
+}
+
+#endif
@@ -0,0 +1,84 @@
+//
+//  counters.h
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+#ifndef counters_h
+#define counters_h
+
+/*
+ 模拟器自身热路径的计数，编译时定义VGB_STATS才有。没有定义时下面的宏什么
+ 都不生成，countersGet返回-1。
+ */
+
+// read8/write8按地址分区
+#define COUNTER_ROM0    0
+#define COUNTER_ROMX    1
+#define COUNTER_VRAM    2
+#define COUNTER_SRAM    3
+#define COUNTER_WRAM    4
+#define COUNTER_ECHO    5
+#define COUNTER_OAM     6
+#define COUNTER_IO      7   // FF00-FF7F和FFFF
+#define COUNTER_HRAM    8
+#define COUNTER_REGIONS 9
+
+struct counters {
+    unsigned long long reads[COUNTER_REGIONS];
+    unsigned long long writes[COUNTER_REGIONS];
+    unsigned long long ioReads[0x100];      // FF00-FFFF的低字节，不含HRAM
+    unsigned long long ioWrites[0x100];
+    unsigned long long interruptCycles;     // interruptCycle的调用次数
+    unsigned long long lines;               // renderLine
+    double lineSeconds;
+    unsigned long long draws;               // screenFrame里缩放/转换的帧
+    double drawSeconds;
+    double sleepSeconds;                    // paceFrame里等待的时间，取自paceStats
+};
+
+#ifdef VGB_STATS
+
+extern struct counters counters;
+double countersNow(void);
+
+static inline int counterRegion(unsigned short a)
+{
+    if (a < 0x8000) return a < 0x4000 ? COUNTER_ROM0 : COUNTER_ROMX;
+    if (a < 0xFE00) return COUNTER_VRAM + ((a - 0x8000) >> 13);
+    if (a < 0xFF00) return COUNTER_OAM;
+    if (a >= 0xFF80 && a != 0xFFFF) return COUNTER_HRAM;
+    return COUNTER_IO;
+}
+
+#define COUNT(x)            (counters.x++)
+#define COUNT_READ(a)       count(counters.reads, counters.ioReads, (a))
+#define COUNT_WRITE(a)      count(counters.writes, counters.ioWrites, (a))
+#define TIME_BEGIN(t)       double t = countersNow()
+#define TIME_END(t, x)      (counters.x += countersNow() - (t))
+
+static inline void count(unsigned long long *regions, unsigned long long *io, unsigned short a)
+{
+    int r = counterRegion(a);
+
+    regions[r]++;
+    if (r == COUNTER_IO) io[a & 0xFF]++;
+}
+
+#else
+
+#define COUNT(x)            ((void)0)
+#define COUNT_READ(a)       ((void)0)
+#define COUNT_WRITE(a)      ((void)0)
+#define TIME_BEGIN(t)       ((void)0)
+#define TIME_END(t, x)      ((void)0)
+
+#endif
+
+int countersGet(struct counters *c);
+void countersReset(void);
+const char *counterRegionName(int region);
+
+#endif /* counters_h */
@@ -0,0 +1,205 @@
+//
+//  cow.c
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+/*
+ 写时复制的快照，给需要反复分叉机器状态的搜索用。
+
+ mmu.c里的数组照旧是当前的内存，读写不经过页表。另外有一张base页表，是
+ 上次fork时各页的内容（带引用计数的只读页，和快照共用）。write8写一页时只
+ 置pageDirty；fork时只有置过的页和base比较，变了才复制一页换进base，然后快照
+ 拿一份base的指针。所以fork的开销是写过的页数，不是32KB，快照之间没写过的
+ 页只有一份。
+
+ restore只写回和base不同的页（指针不同或者fork之后写过），之后base就是那个
+ 快照的页表。寄存器等几百字节的状态每个快照各存一份。
+
+ 页和快照结构都放在各自的空闲链表里复用，稳定之后fork/restore不分配内存。
+ */
+
+#include "cow.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mmu.h"
+#include "state.h"
+
+#define CHUNK   64      // 页池每次扩充的页数
+
+struct cowPage {
+    union {
+        int refs;
+        struct cowPage *next;   // 在空闲链表里时
+    };
+    unsigned char data[MEM_PAGE];
+};
+
+struct cowSnapshot {
+    struct machineCore core;
+    struct cowPage *pages[MEM_PAGES];
+    struct cowSnapshot *next;   // 空闲链表
+};
+
+static struct cowPage *base[MEM_PAGES];
+static struct cowPage *freePages;
+static struct cowSnapshot *freeSnapshots;
+static void **chunks;           // 分配过的块，cowShutdown时释放
+static int chunkN, chunkCap;
+
+static struct cowStats stats;
+
+static void *track(void *block)
+{
+    if (!block) return NULL;
+    if (chunkN == chunkCap) {
+        int cap = chunkCap ? chunkCap * 2 : 16;
+        void **c = realloc(chunks, cap * sizeof(*c));
+        if (!c) {
+            free(block);
+            return NULL;
+        }
+        chunks = c;
+        chunkCap = cap;
+    }
+    chunks[chunkN++] = block;
+    return block;
+}
+
+static struct cowPage *newPage(void)
+{
+    struct cowPage *page;
+
+    if (!freePages) {
+        struct cowPage *chunk = track(malloc(CHUNK * sizeof(*chunk)));
+        if (!chunk) return NULL;
+        for (int i = 0; i < CHUNK; i++) {
+            chunk[i].next = freePages;
+            freePages = &chunk[i];
+        }
+        stats.pagesAllocated += CHUNK;
+    }
+    page = freePages;
+    freePages = page->next;
+    page->refs = 1;
+    stats.pagesInUse++;
+    return page;
+}
+
+static void unref(struct cowPage *page)
+{
+    if (page && --page->refs == 0) {
+        page->next = freePages;
+        freePages = page;
+        stats.pagesInUse--;
+    }
+}
+
+static struct cowSnapshot *newSnapshot(void)
+{
+    struct cowSnapshot *s;
+
+    if (!freeSnapshots) {
+        struct cowSnapshot *chunk = track(malloc(CHUNK * sizeof(*chunk)));
+        if (!chunk) return NULL;
+        for (int i = 0; i < CHUNK; i++) {
+            chunk[i].next = freeSnapshots;
+            freeSnapshots = &chunk[i];
+        }
+    }
+    s = freeSnapshots;
+    freeSnapshots = s->next;
+    return s;
+}
+
+struct cowSnapshot *cowFork(void)
+{
+    struct cowSnapshot *s = newSnapshot();
+
+    if (!s) return NULL;
+    for (int p = 0; p < MEM_PAGES; p++) {
+        unsigned char *live;
+        int size;
+
+        if (!(pageDirty[p] & DIRTY_COW) && base[p]) continue;
+        live = memPage(p, &size);
+        if (!base[p] || memcmp(base[p]->data, live, size)) {
+            struct cowPage *page = newPage();
+            if (!page) {
+                s->next = freeSnapshots;
+                freeSnapshots = s;
+                return NULL;
+            }
+            memcpy(page->data, live, size);
+            unref(base[p]);
+            base[p] = page;
+            stats.pagesCopied++;
+        }
+        pageDirty[p] &= ~DIRTY_COW;
+    }
+    for (int p = 0; p < MEM_PAGES; p++) {
+        s->pages[p] = base[p];
+        base[p]->refs++;
+    }
+    stateSaveCore(&s->core);
+    stats.forks++;
+    stats.snapshots++;
+    return s;
+}
+
+void cowRestore(const struct cowSnapshot *s)
+{
+    for (int p = 0; p < MEM_PAGES; p++) {
+        unsigned char *live;
+        int size;
+
+        if (base[p] == s->pages[p] && !(pageDirty[p] & DIRTY_COW)) continue;
+        if (base[p] != s->pages[p]) {
+            s->pages[p]->refs++;
+            unref(base[p]);
+            base[p] = s->pages[p];
+        }
+        live = memPage(p, &size);
+        memcpy(live, base[p]->data, size);
+        pageDirty[p] = 0xFF & ~DIRTY_COW;//内容变了，其他使用者（digest.c）要重新算
+        stats.pagesRestored++;
+    }
+    stateLoadCore(&s->core);
+    stats.restores++;
+}
+
+void cowRelease(struct cowSnapshot *s)
+{
+    if (!s) return;
+    for (int p = 0; p < MEM_PAGES; p++) unref(s->pages[p]);
+    s->next = freeSnapshots;
+    freeSnapshots = s;
+    stats.snapshots--;
+}
+
+void cowShutdown(void)
+{
+    for (int i = 0; i < chunkN; i++) free(chunks[i]);
+    free(chunks);
+    chunks = NULL;
+    chunkN = chunkCap = 0;
+    freePages = NULL;
+    freeSnapshots = NULL;
+    memset(base, 0, sizeof(base));
+    stats.snapshots = stats.pagesInUse = stats.pagesAllocated = 0;
+}
+
+void cowGetStats(struct cowStats *s)
+{
+    *s = stats;
+}
+
+void cowResetStats(void)
+{
+    stats.forks = stats.restores = 0;
+    stats.pagesCopied = stats.pagesRestored = 0;
+}
@@ -0,0 +1,36 @@
+//
+//  cow.h
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+#ifndef cow_h
+#define cow_h
+
+struct cowSnapshot;
+
+struct cowStats {
+    unsigned long forks;
+    unsigned long restores;
+    unsigned long pagesCopied;      // fork时复制的页
+    unsigned long pagesRestored;    // restore时写回的页
+    unsigned long snapshots;        // 还没释放的快照
+    unsigned long pagesInUse;       // 快照共用的页
+    unsigned long pagesAllocated;   // 页池的大小
+};
+
+// 以下只在模拟线程调用。按mmu.h的分页，快照只复制上次fork之后写过的页（pageDirty的DIRTY_COW位），
+// 其余的页和之前的快照共用
+struct cowSnapshot *cowFork(void);      // 内存不够返回NULL
+void cowRestore(const struct cowSnapshot *snapshot);
+void cowRelease(struct cowSnapshot *snapshot);
+
+// 释放页池，之前的快照都不能再用
+void cowShutdown(void);
+
+void cowGetStats(struct cowStats *stats);
+void cowResetStats(void);
+
+#endif /* cow_h */
@@ -2,7 +2,10 @@
 #include "cpu.h"
 
 #include "mmu.h"
+#include "fuse.h"
 #include "interrupt.h"
+#include "profile.h"
+#include "trace.h"
 
 struct registers registers;
 
@@ -19,8 +22,10 @@ void cpuInit(void)
     registers.SP = 0xFFFE;
     registers.PC = 0x0100;
     registers.cycles = 0;
+    registers.halted = 0;
     
     memInit();
+    fuseReset();
 }
 
 void cpuInterrupt(unsigned short address)
@@ -29,6 +34,12 @@ void cpuInterrupt(unsigned short address)
     registers.SP -= 2;
     write16(registers.SP, registers.PC);
     registers.PC = address;
+#ifdef VGB_PROFILE
+    profileInterrupt(address);
+#endif
+#ifdef VGB_TRACE
+    traceInterrupt(address);
+#endif
 }
 
 unsigned int getCycles(void)
@@ -41,14 +52,40 @@ unsigned int getCycles(void)
 // cpu执行循环
 void cbPrefix(unsigned char inst);
 
+#ifdef VGB_PROFILE
+static void execute(void);
+
+// 执行前记下PC、SP、周期，执行后交给profile.c
+void cpuCycle(void)
+{
+    unsigned short pc = registers.PC, sp = registers.SP;
+    unsigned int cycles = registers.cycles;
+    unsigned int halted = registers.halted;
+    unsigned int op = halted ? 0 : peek8(pc);//不走read8，不算进VGB_STATS的计数
+
+    if (op == 0xCB) op = PROFILE_CB + peek8(pc + 1);
+
+    execute();
+    profileStep(halted ? PROFILE_HALT : pc, op, sp, registers.cycles - cycles);
+}
+
+static void execute(void)
+#else
 void cpuCycle(void)
+#endif
 {
-    static int halted = 0;
-    if (halted) {
+    if (registers.halted) {
         registers.cycles += 1;
         return;
     }
 
+#ifdef VGB_TRACE
+    traceInstruction();
+#endif
+#if !defined(VGB_PROFILE) && !defined(VGB_TRACE)
+    if (fuseStep()) return;//性能分析、记录轨迹时逐条执行
+#endif
+
     int i;
     unsigned char s;
     unsigned short t;
@@ -163,7 +200,7 @@ void cpuCycle(void)
             registers.cycles += 1;
             break;
         case 0x10:    // STOP
-            halted = 1;
+            registers.halted = 1;
             registers.PC += 1;
             registers.cycles += 1;
             break;
@@ -774,7 +811,7 @@ void cpuCycle(void)
             registers.cycles += 2;
             break;
         case 0x76:    // HALT
-            halted = 1;
+            registers.halted = 1;
             registers.PC += 1;
             registers.cycles += 1;
             break;
@@ -42,6 +42,7 @@ struct registers
     unsigned short PC;
     
     unsigned int cycles;//cpu执行总周期
+    unsigned int halted;//HALT/STOP之后不再取指
 };
 
 void cpuInit(void);
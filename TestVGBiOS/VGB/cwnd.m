@@ -13,141 +13,140 @@
 #include <stdio.h>
 
 #include "hqx.h"
+#include "input.h"
+#include "lcd.h"
+#include "video.h"
+#include "pace.h"
+#include "scale.h"
+#include "present.h"
+#include "rewind.h"
+#include "screen.h"
+#include "vmain.h"
+
+#define    SCALER       NULL    //默认滤镜(scale.c中的名字，如"hq2x")，NULL为不缩放
+#define    FORMAT       VIDEO_RGBA8888  //不缩放时的输出格式(RGBA/BGRA/GREY8，CoreGraphics不支持RGB565)，滤镜只支持32位
+
+static int pace_mode = PACE_EXACT;
+static int rewind_ok;   //倒带缓冲分配成功
 
-uint32_t   RGBtoYUV[16777216];
-uint32_t   YUV1, YUV2;
+int wnd_init(const char *filename)
+{
+    hqxSetThreads((int)[[NSProcessInfo processInfo] activeProcessorCount]);//HQX按行带并行
+    screenInit(SCALER, FORMAT, NULL);
+    paceInit(pace_mode);
+    //Tetris每分钟约1.5MB(hwnd -w)，4MB约2.5分钟；分配失败就不倒带
+    rewind_ok = rewindInit(REWIND_BUDGET, 1) == 0;
+    if (!rewind_ok) fprintf(stderr, "rewind: out of memory, disabled\n");
+    
+    return 0;
+}
 
-HQX_API void HQX_CALLCONV hqxInit(void)
+//每块呈现缓冲一个常驻的位图上下文，尺寸或格式变了才重建
+static CGContextRef wnd_context(const struct presentFrame *frame)
 {
-    /* Initalize RGB to YUV lookup table */
-    uint32_t c, r, g, b, y, u, v;
-    for (c = 0; c < 16777215; c++) {
-        r = (c & 0xFF0000) >> 16;
-        g = (c & 0x00FF00) >> 8;
-        b = c & 0x0000FF;
-        y = (uint32_t)(0.299*r + 0.587*g + 0.114*b);
-        u = (uint32_t)(-0.169*r - 0.331*g + 0.5*b) + 128;
-        v = (uint32_t)(0.5*r - 0.419*g - 0.081*b) + 128;
-        RGBtoYUV[c] = (y << 16) + (u << 8) + v;
+    static CGContextRef ctx[PRESENT_BUFFERS];
+    static struct presentFrame made[PRESENT_BUFFERS];
+    struct presentFrame *m = &made[frame->index];
+    CGColorSpaceRef colorRef;
+    
+    if (ctx[frame->index] && m->pixels == frame->pixels && m->width == frame->width && m->height == frame->height &&
+        m->stride == frame->stride && m->format == frame->format) {
+        return ctx[frame->index];
     }
+    CGContextRelease(ctx[frame->index]);
+    switch (frame->format) {
+        case VIDEO_BGRA8888:
+            colorRef = CGColorSpaceCreateDeviceRGB();
+            ctx[frame->index] = CGBitmapContextCreate(frame->pixels, frame->width, frame->height, 8, frame->stride, colorRef, kCGImageAlphaPremultipliedFirst | kCGBitmapByteOrder32Little);//BGRA
+            break;
+        case VIDEO_GREY8:
+            colorRef = CGColorSpaceCreateDeviceGray();
+            ctx[frame->index] = CGBitmapContextCreate(frame->pixels, frame->width, frame->height, 8, frame->stride, colorRef, kCGImageAlphaNone);
+            break;
+        default:
+            colorRef = CGColorSpaceCreateDeviceRGB();
+            ctx[frame->index] = CGBitmapContextCreate(frame->pixels, frame->width, frame->height, 8, frame->stride, colorRef, kCGImageAlphaPremultipliedLast);//RGBA
+            break;
+    }
+    CGColorSpaceRelease(colorRef);
+    *m = *frame;
+    return ctx[frame->index];
 }
 
-#define    WIDTH        160
-#define    HEIGHT       144
-#define    MAG          1   //magnification;
+//宿主在屏幕刷新时调用：有新帧时返回它的图片(调用者释放)，否则返回NULL
+//图片和缓冲是写时复制的关系，缓冲在下一次取帧之前归宿主独占，不会被模拟线程改写
+CGImageRef wnd_frontImage(void)
+{
+    struct presentFrame frame;
+    
+    if (!presentAcquire(&frame)) return NULL;
+    return CGBitmapContextCreateImage(wnd_context(&frame));
+}
 
-static uint8_t pic_mem_orgl[WIDTH * HEIGHT * 4];
-static uint8_t pic_mem_frnt[WIDTH * HEIGHT * 4 * MAG * MAG];
-static uint32_t frame_counter;
-static double time_frame0;
-static uint8_t ctrl0[2] = {0, 0};
+void wnd_draw(uint8_t* pixels)
+{
+    screenFrame();
+    paceFrame();//多余的时间还给系统
+}
 
-unsigned int* getPixels(void)
+//按名字选滤镜(见scale.c)，NULL或找不到时不缩放；下一帧生效
+void wnd_setScaler(const char *name)
 {
-    return (unsigned int*)pic_mem_orgl;
+    screenSetScaler(name ? scalerFind(name) : NULL);
 }
 
-int wnd_init(const char *filename)
+//整数倍适配：family族("nearest"/"scale"/"xbr"/"hq")中能放进viewW x viewH的最大倍数
+void wnd_fitScaler(const char *family, int viewW, int viewH)
 {
-    hqxInit();
-    
-    frame_counter = 0;
-    time_frame0 =  CFAbsoluteTimeGetCurrent();
-    
-    return 0;
+    screenSetScaler(scalerFit(family, viewW, viewH, SCREEN_WIDTH, SCREEN_HEIGHT));
 }
 
-void byte2image(uint8_t *bytes, uint64_t width, uint64_t height)
+//在下一帧结束时给所有滤镜跑分，结果输出到日志
+void wnd_benchmarkScalers(void)
 {
-    CGColorSpaceRef colorRef = CGColorSpaceCreateDeviceRGB();
-    CGContextRef ctxRef = CGBitmapContextCreate(bytes, width, height, 8, width*4, colorRef, kCGImageAlphaPremultipliedLast);//RGBA
-    CGImageRef imgRef = CGBitmapContextCreateImage(ctxRef);
-    UIImage* image = [UIImage imageWithCGImage:imgRef];
-    if (image) {
-        [[NSNotificationCenter defaultCenter] postNotificationName:@"gb_video" object:nil userInfo:@{@"video":image}];
-    }
-    CGColorSpaceRelease(colorRef);
-    CGImageRelease(imgRef);
-    CGContextRelease(ctxRef);
+    screenBenchmark();
 }
 
-void wnd_draw(uint8_t* pixels)
+//快进：不限速，每frameSkip+1帧呈现一帧；frameSkip为0时恢复正常
+//两项设置都交给模拟线程在帧边界切换(pace.c、lcd.c)
+void wnd_fastForward(int frameSkip)
 {
-    if (MAG == 1) {
-        memcpy(pic_mem_frnt, pic_mem_orgl, WIDTH*HEIGHT*4);
-    }
-    if (MAG == 2) {
-        hq2x_32((uint32_t*)pic_mem_orgl, (uint32_t*)pic_mem_frnt, WIDTH, HEIGHT);
-    }
-    if (MAG == 3) {
-        hq3x_32((uint32_t*)pic_mem_orgl, (uint32_t*)pic_mem_frnt, WIDTH, HEIGHT);
-    }
-    if (MAG == 4) {
-        hq4x_32((uint32_t*)pic_mem_orgl, (uint32_t*)pic_mem_frnt, WIDTH, HEIGHT);
-    }
-    
-    ++frame_counter;
-    double delay = (frame_counter*0.016667+time_frame0) - CFAbsoluteTimeGetCurrent();
-    if (delay > 0) {
-        [NSThread sleepForTimeInterval:delay];//多余的时间还给系统
-    }
-    
-    byte2image(pic_mem_frnt, WIDTH, HEIGHT);
+    paceSetMode(frameSkip > 0 ? PACE_UNTHROTTLED : pace_mode);
+    lcdSetFrameSkip(frameSkip);
 }
 
-void wnd_key2btn(int key, char isDown)
+//PACE_UNTHROTTLED / PACE_EXACT / PACE_DISPLAY
+void wnd_setPacing(int mode)
 {
-    uint8_t btn = 0;
-    switch (key) {
-        case 7:
-            btn = 1 << 7;//START
-            break;
-        case 6:
-            btn = 1 << 6;//SELECT
-            break;
-        case 5:
-            btn = 1 << 5;//B
-            break;
-        case 4:
-            btn = 1 << 4;//A
-            break;
-        case 3:
-            btn = 1 << 3;//Down
-            break;
-        case 2:
-            btn = 1 << 2;//UP
-            break;
-        case 1:
-            btn = 1 << 1;//LEFT
-            break;
-        case 0:
-            btn = 1 << 0;//RIGHT
-            break;
-    }
-    if (isDown){
-        ctrl0[0] |= btn;
-        ctrl0[1] |= btn;
-    }else if (!isDown){
-        ctrl0[0] &= ~btn;
-        ctrl0[1] &= ~btn;
-    }
+    pace_mode = mode;
+    paceSetMode(mode);
 }
 
-int wnd_updateEvent(void)
+//超前运行frames帧(0关闭，最多RUNAHEAD_MAX)，画面和输入反应提前frames帧，CPU开销是frames+1倍
+void wnd_setRunAhead(int frames)
 {
-    return 0;
+    vmainSetRunAhead(frames);
 }
 
-unsigned int getButton(void)
+//按住倒带键时传1，松开传0：每帧倒回一帧，倒到最早的快照后停住
+void wnd_setRewind(int on)
 {
-    char ctl = ctrl0[0];
-    return (ctl&0xF0)>>4;
+    if (rewind_ok) vmainSetRewind(on);
 }
 
-unsigned int getDirection(void)
+//屏幕刷新时调用(CADisplayLink)
+void wnd_displayTick(void)
 {
-    char ctl = ctrl0[0];
-    return (ctl&0x0F)>>0;
+    paceDisplayTick();
 }
 
+//按键事件(UI线程)：key为INPUT_RIGHT..INPUT_START，带时间戳排队，由模拟线程在对应的周期生效
+void wnd_key2btn(int key, char isDown)
+{
+    inputPush(key, isDown);
+}
 
+int wnd_updateEvent(void)
+{
+    return 0;
+}
@@ -0,0 +1,90 @@
+//
+//  digest.c
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+/*
+ 每帧的状态摘要，用来比较两次运行从哪一帧开始分岔。
+
+ 内存每页留一个hash64，只有write8置过DIRTY_HASH位的页才重新算，memory是这
+ 99个页哈希的哈希，一帧通常只写几页。cpu按存档的字段和宽度算（stateHashCore），
+ 和结构体布局无关。
+ */
+
+#include "digest.h"
+
+#include <string.h>
+#include <time.h>
+
+#include "hash.h"
+#include "lcd.h"
+#include "mmu.h"
+#include "state.h"
+
+static uint64_t pageHash[MEM_PAGES];
+static struct digestStats stats;
+
+static double now(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// cpu和memory两项
+static void machine(struct digest *d)
+{
+    for (int p = 0; p < MEM_PAGES; p++) {
+        unsigned char *page;
+        int size;
+
+        if (!(pageDirty[p] & DIRTY_HASH)) continue;
+        page = memPage(p, &size);
+        pageHash[p] = hash64(page, size, p);
+        pageDirty[p] &= ~DIRTY_HASH;
+        stats.pagesHashed++;
+    }
+    d->cpu = stateHashCore();
+    d->memory = hash64(pageHash, sizeof(pageHash), 0);
+}
+
+uint64_t digestMachine(void)
+{
+    struct digest d;
+    uint64_t part[2];
+
+    machine(&d);
+    part[0] = d.cpu;
+    part[1] = d.memory;
+    return hash64(part, sizeof(part), 0);
+}
+
+void digestCompute(struct digest *d)
+{
+    double start = now();
+    uint64_t part[3];
+
+    machine(d);
+    d->frame = lcdFrameSkipped() ? 0 : hash64(getPixels(), 160 * 144, 0);
+    part[0] = d->cpu;
+    part[1] = d->memory;
+    part[2] = d->frame;
+    d->all = hash64(part, sizeof(part), 0);
+
+    stats.computed++;
+    stats.seconds += now() - start;
+}
+
+void digestGetStats(struct digestStats *s)
+{
+    *s = stats;
+}
+
+void digestResetStats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
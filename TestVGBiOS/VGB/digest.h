@@ -0,0 +1,36 @@
+//
+//  digest.h
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+#ifndef digest_h
+#define digest_h
+
+#include <stdint.h>
+
+struct digest {
+    uint64_t cpu;       // 寄存器和各部件的内部状态
+    uint64_t memory;    // vram到hram的内存数组
+    uint64_t frame;     // 这一帧的画面，没有渲染为0
+    uint64_t all;       // 以上三个合起来
+};
+
+struct digestStats {
+    unsigned long computed;
+    unsigned long pagesHashed;  // 重新算过的页，其余用上次的结果
+    double seconds;             // digestCompute用掉的时间
+};
+
+// 只在模拟线程、帧之间调用。内存按mmu.h的分页，只重新算上次之后写过的页
+// （pageDirty的DIRTY_HASH位）
+void digestCompute(struct digest *digest);
+// 只把cpu和memory合起来（跳过渲染的帧也能比较），不算一次digestCompute
+uint64_t digestMachine(void);
+
+void digestGetStats(struct digestStats *stats);
+void digestResetStats(void);
+
+#endif /* digest_h */
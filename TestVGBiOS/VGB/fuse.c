@@ -0,0 +1,264 @@
+//
+//  fuse.c
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+/*
+ 超级指令：把常见的两三条指令一次执行，省掉中间几轮主循环（取指、switch，
+ 以及inputCycle/interruptCycle/timerCycle/lcdCycle）。
+
+ ROM不会变，所以第一次执行到某个地址时按cart[]识别一次，结果记在kind[]里。
+
+ 只在中间那几轮部件循环都不会有动作时才合并，结果和逐条执行逐位相同：
+   输入：到组里最后一轮为止没有事件要生效
+   中断：没有EI的延迟，也没有能响应的中断；定时器开着并且允许了定时器中断时
+         不合并（中途溢出会在下一条指令后进中断）
+   LCD：到组里最后一轮为止LY不变（换行时才渲染、置VBlank、结束一帧），模式
+         标志只有读FF41才看得到
+ timerCycle每次最多走一拍，不能合成一次，所以组里每条指令之后照样调用。
+ 第一条之后的指令不读写FF00-FF7F（LD (DE),A写到那里时不合并），那里的值
+ 要靠各部件循环更新。各指令的语义照抄cpu.c里对应的case。
+ */
+
+#include "fuse.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "cpu.h"
+#include "input.h"
+#include "interrupt.h"
+#include "lcd.h"
+#include "mmu.h"
+#include "timer.h"
+
+extern struct registers registers;
+
+#define UNKNOWN 0
+#define NONE    0xFF
+
+static unsigned char kind[0x8000];  // 组合+1，NONE为不是
+static int enabled = 1;
+static struct fuseStats stats;
+
+void fuseSetEnabled(int on)
+{
+    enabled = on;
+}
+
+int fuseEnabled(void)
+{
+    return enabled;
+}
+
+void fuseReset(void)
+{
+    memset(kind, UNKNOWN, sizeof(kind));
+}
+
+static int isDec(unsigned char op)
+{
+    return (op & 0xC7) == 0x05 && op != 0x35;   // DEC r，不含DEC (HL)
+}
+
+static int isJr(unsigned char op)
+{
+    return op == 0x20 || op == 0x28;
+}
+
+static int decode(unsigned short pc)
+{
+    const unsigned char *p = &cart[pc];
+    int left = 0x8000 - pc;
+
+    if (left >= 5 && p[0] == 0xF0 && p[2] == 0xA7 && isJr(p[3])) return FUSE_POLL_AND;
+    if (left >= 6 && p[0] == 0xF0 && p[2] == 0xFE && isJr(p[4])) return FUSE_POLL_CP;
+    if (left >= 3 && isDec(p[0]) && p[1] == 0x20) return FUSE_DEC_JR;
+    if (left >= 3 && p[0] == 0x2A && p[1] == 0x12 && p[2] == 0x13) return FUSE_COPY_INC;
+    if (left >= 2 && p[0] == 0x2A && p[1] == 0x12) return FUSE_COPY;
+    return -1;
+}
+
+// 从现在起再过prefix个周期（组里最后一条指令之前）各部件都不会有动作
+static int quiet(unsigned int prefix)
+{
+    unsigned int last = registers.cycles + prefix;
+    unsigned char irq = interrupt.flags | (timer.started ? TIMER : 0);
+
+    if (interrupt.pending == 1) return 0;
+    if (interrupt.master && (interrupt.enable & irq & 0x1F)) return 0;
+    if ((int)(lcdNextLine() - last) <= 0) return 0;
+    if (inputDue(last)) return 0;
+    return 1;
+}
+
+// 以下和cpu.c里对应的case相同
+
+static void ldhA(void)      // F0 LD A,($FF00+n)
+{
+    unsigned char s = read8(registers.PC+1);
+    registers.A = read8(0xFF00 + s);
+    registers.PC += 2;
+    registers.cycles += 3;
+}
+
+static void andA(void)      // A7 AND A
+{
+    registers.A &= registers.A;
+    SET_Z(!registers.A);
+    SET_N(0);
+    SET_H(1);
+    SET_C(0);
+    registers.PC += 1;
+    registers.cycles += 1;
+}
+
+static void cpN(void)       // FE CP n
+{
+    unsigned char s = read8(registers.PC+1);
+    SET_Z((registers.A == s));
+    SET_N(1);
+    SET_H((((registers.A-s) & 0xF) > (registers.A & 0xF)));
+    SET_C((registers.A < s));
+    registers.PC += 2;
+    registers.cycles += 2;
+}
+
+static void jr(void)        // 20 JR NZ,e / 28 JR Z,e
+{
+    int z = read8(registers.PC) == 0x28;
+    if (FLAG_Z == z) {
+        registers.PC += (signed char)read8(registers.PC+1) + 2;
+        registers.cycles += 3;
+    } else {
+        registers.PC += 2;
+        registers.cycles += 2;
+    }
+}
+
+static void dec(void)       // 05/0D/15/1D/25/2D/3D DEC r
+{
+    static const size_t offsets[8] = {
+        offsetof(struct registers, B), offsetof(struct registers, C),
+        offsetof(struct registers, D), offsetof(struct registers, E),
+        offsetof(struct registers, H), offsetof(struct registers, L),
+        0, offsetof(struct registers, A),
+    };
+    unsigned char *r = (unsigned char *)&registers + offsets[read8(registers.PC) >> 3];
+    *r -= 1;
+    SET_Z(!*r);
+    SET_N(1);
+    SET_H(((*r & 0xF) == 0xF));
+    registers.PC += 1;
+    registers.cycles += 1;
+}
+
+static void ldiAHL(void)    // 2A LD A,(HL+)
+{
+    registers.A = read8(GET_HL());
+    SET_HL((GET_HL()+1));
+    registers.PC += 1;
+    registers.cycles += 2;
+}
+
+static void ldDEA(void)     // 12 LD (DE),A
+{
+    write8(GET_DE(), registers.A);
+    registers.PC += 1;
+    registers.cycles += 2;
+}
+
+static void incDE(void)     // 13 INC DE
+{
+    SET_DE((GET_DE() + 1));
+    registers.PC += 1;
+    registers.cycles += 2;
+}
+
+// 第一条之后写的地址不在FF00-FF7F、FFFF
+static int plainAddress(unsigned short address)
+{
+    return address < 0xFF00 || (address >= 0xFF80 && address != 0xFFFF);
+}
+
+int fuseStep(void)
+{
+    unsigned short pc = registers.PC;
+    int k;
+
+    if (!enabled || pc >= 0x8000) return 0;
+    if (kind[pc] == UNKNOWN) {
+        k = decode(pc);
+        kind[pc] = k < 0 ? NONE : k + 1;
+    }
+    if (kind[pc] == NONE) return 0;
+    k = kind[pc] - 1;
+
+    switch (k) {
+        case FUSE_POLL_AND:
+            if (!quiet(3 + 1)) break;
+            ldhA(); timerCycle();
+            andA(); timerCycle();
+            jr();
+            stats.groups[k]++;
+            stats.instructions += 3;
+            return 1;
+        case FUSE_POLL_CP:
+            if (!quiet(3 + 2)) break;
+            ldhA(); timerCycle();
+            cpN(); timerCycle();
+            jr();
+            stats.groups[k]++;
+            stats.instructions += 3;
+            return 1;
+        case FUSE_DEC_JR:
+            if (!quiet(1)) break;
+            dec(); timerCycle();
+            jr();
+            stats.groups[k]++;
+            stats.instructions += 2;
+            return 1;
+        case FUSE_COPY_INC:
+            if (!quiet(2 + 2) || !plainAddress(GET_DE())) break;
+            ldiAHL(); timerCycle();
+            ldDEA(); timerCycle();
+            incDE();
+            stats.groups[k]++;
+            stats.instructions += 3;
+            return 1;
+        case FUSE_COPY:
+            if (!quiet(2) || !plainAddress(GET_DE())) break;
+            ldiAHL(); timerCycle();
+            ldDEA();
+            stats.groups[k]++;
+            stats.instructions += 2;
+            return 1;
+    }
+    stats.declined++;
+    return 0;
+}
+
+void fuseGetStats(struct fuseStats *s)
+{
+    *s = stats;
+}
+
+void fuseResetStats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
+
+const char *fuseName(int pattern)
+{
+    static const char *const names[FUSE_PATTERNS] = {
+        "LDH A,(n); AND A; JR cc,e",
+        "LDH A,(n); CP n; JR cc,e",
+        "DEC r; JR NZ,e",
+        "LD A,(HL+); LD (DE),A; INC DE",
+        "LD A,(HL+); LD (DE),A",
+    };
+    return pattern >= 0 && pattern < FUSE_PATTERNS ? names[pattern] : "?";
+}
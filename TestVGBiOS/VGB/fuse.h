@@ -0,0 +1,38 @@
+//
+//  fuse.h
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+#ifndef fuse_h
+#define fuse_h
+
+// 合并执行的指令组合
+#define FUSE_POLL_AND   0   // LDH A,(n); AND A; JR Z/NZ,e   等标志的循环
+#define FUSE_POLL_CP    1   // LDH A,(n); CP n; JR Z/NZ,e    等LY/标志的循环
+#define FUSE_DEC_JR     2   // DEC r; JR NZ,e                延时循环
+#define FUSE_COPY_INC   3   // LD A,(HL+); LD (DE),A; INC DE 复制循环
+#define FUSE_COPY       4   // LD A,(HL+); LD (DE),A
+#define FUSE_PATTERNS   5
+
+struct fuseStats {
+    unsigned long long groups[FUSE_PATTERNS];   // 合并执行的次数
+    unsigned long long instructions;            // 合并执行的指令数
+    unsigned long long declined;                // 认出了组合，但中间部件会有动作，逐条执行
+};
+
+void fuseSetEnabled(int on);    // 默认打开
+int fuseEnabled(void);
+void fuseReset(void);           // 换了卡带，重新识别
+
+// cpuCycle调用：PC处是ROM里已知的组合，并且几条指令之间各部件（输入、中断、
+// 定时器、LCD）都不会有动作时，一次执行完整组并返回1
+int fuseStep(void);
+
+void fuseGetStats(struct fuseStats *stats);
+void fuseResetStats(void);
+const char *fuseName(int pattern);
+
+#endif /* fuse_h */
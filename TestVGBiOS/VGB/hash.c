@@ -0,0 +1,100 @@
+//
+//  hash.c
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+/*
+ XXH64：每次吃32字节，四路并行累加，比逐字节的FNV快一个数量级，用来给
+ 帧缓冲和内存页算校验。
+ */
+
+#include "hash.h"
+
+#include <string.h>
+
+#define P1  0x9E3779B185EBCA87ULL
+#define P2  0xC2B2AE3D27D4EB4FULL
+#define P3  0x165667B19E3779F9ULL
+#define P4  0x85EBCA77C2B2AE63ULL
+#define P5  0x27D4EB2F165667C5ULL
+
+static uint64_t rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t read64(const unsigned char *p)
+{
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;   // 只考虑小端（arm64/x86）
+}
+
+static uint32_t read32(const unsigned char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static uint64_t round64(uint64_t acc, uint64_t input)
+{
+    acc += input * P2;
+    acc = rotl(acc, 31);
+    return acc * P1;
+}
+
+static uint64_t merge(uint64_t acc, uint64_t v)
+{
+    acc ^= round64(0, v);
+    return acc * P1 + P4;
+}
+
+uint64_t hash64(const void *data, size_t length, uint64_t seed)
+{
+    const unsigned char *p = data, *end = p + length;
+    uint64_t h;
+
+    if (length >= 32) {
+        uint64_t v1 = seed + P1 + P2, v2 = seed + P2, v3 = seed, v4 = seed - P1;
+        do {
+            v1 = round64(v1, read64(p));
+            v2 = round64(v2, read64(p + 8));
+            v3 = round64(v3, read64(p + 16));
+            v4 = round64(v4, read64(p + 24));
+            p += 32;
+        } while (end - p >= 32);
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = merge(h, v1);
+        h = merge(h, v2);
+        h = merge(h, v3);
+        h = merge(h, v4);
+    } else {
+        h = seed + P5;
+    }
+    h += length;
+
+    for (; end - p >= 8; p += 8) {
+        h ^= round64(0, read64(p));
+        h = rotl(h, 27) * P1 + P4;
+    }
+    if (end - p >= 4) {
+        h ^= (uint64_t)read32(p) * P1;
+        h = rotl(h, 23) * P2 + P3;
+        p += 4;
+    }
+    for (; p < end; p++) {
+        h ^= *p * P5;
+        h = rotl(h, 11) * P1;
+    }
+
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    h ^= h >> 32;
+    return h;
+}
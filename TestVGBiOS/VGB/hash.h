@@ -0,0 +1,18 @@
+//
+//  hash.h
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+#ifndef hash_h
+#define hash_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+// XXH64，和xxHash的参考实现结果一致
+uint64_t hash64(const void *data, size_t length, uint64_t seed);
+
+#endif /* hash_h */
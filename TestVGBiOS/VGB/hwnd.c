@@ -0,0 +1,643 @@
+//
+//  hwnd.c
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+/*
+ 无界面的宿主（Linux/macOS命令行），代替cwnd.m，用来在电脑上跑分和调试。
+ 不参与iOS工程的编译，编译方法见README。
+
+ hwnd rom.gb [-n 帧数] [-s 滤镜] [-p 节奏模式] [-r 超前帧数] [-l 间隔] [-L 读档] [-S 存档]
+            [-w 倒带KB [-b 倒带帧数]] [-f 帧数] [-R 录像 | -P 录像] [-V 间隔] [-c N] [-o 文件 | -m 共享内存名]
+
+ -o 把每个新帧的像素依次追加写入文件；-m 把呈现缓冲本身放在POSIX共享内存里，
+ 其他进程按shmHeader读取最新帧，整条路径没有拷贝和分配。
+ -c 检查呈现缓冲只补画变化区域的结果：本进程每隔1到N帧（随机）才取一次帧，
+ 取到的帧和当前画面整帧重画（同一个滤镜）逐字节比较，不一致时退出码为1。
+ -l 测输入延迟：每隔若干帧按一次键（先按三次START进入游戏，之后左右交替），
+ 按住LATENCY_HOLD帧，结束时输出延迟直方图。
+ -L 开始前读档；-S 结束时存档，并测存档/读档的耗时。
+ -w 打开倒带，给定内存预算；-b 最后这么多帧按住倒带。结束时输出每帧存快照的
+ 耗时和每分钟倒带要的内存。
+ -f 前这么多帧每帧fork一个写时复制的快照，结束时输出fork的耗时、快照共用的
+ 内存，以及在最后两个快照之间来回restore的耗时（和整份存取比较）；再检查restore
+ 之后的摘要和全部重新算的一致，不一致时退出码为1。
+ -R 录像，结束时写文件；-P 回放录像（帧数取录像的长度），逐帧比较画面哈希和
+ 机器状态，不一致或者一帧都没比较时退出码为1。
+ -V 每隔这么多帧把当前画面分别用SIMD和标量参考代码（hqxSetSimd）跑一遍
+ hq2x/hq3x/hq4x，再分别用邻域缓存和普通路径跑一遍hq2x，输出逐字节比较，
+ 不一致时退出码为1；结束时还输出两条hq2x路径每帧的耗时。
+ */
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cow.h"
+#include "hqx.h"
+#include "input.h"
+#include "latency.h"
+#include "lcd.h"
+#include "mmu.h"
+#include "movie.h"
+#include "digest.h"
+#include "hash.h"
+#include "profile.h"
+#include "counters.h"
+#include "fuse.h"
+#include "trace.h"
+#include "pace.h"
+#include "present.h"
+#include "rewind.h"
+#include "scale.h"
+#include "screen.h"
+#include "state.h"
+#include "video.h"
+#include "vmain.h"
+
+// 共享内存开头的描述，后面紧跟PRESENT_BUFFERS块呈现缓冲
+struct shmHeader {
+    volatile unsigned long fence;   // 最新帧，读者看到它变化后再读index
+    volatile int index;
+    int width;
+    int height;
+    int stride;
+    int format;
+    int buffers;
+    int size;       // 每块缓冲的字节数
+};
+
+#define SHM_HEADER  4096
+#define LATENCY_HOLD    3
+
+static long frames = 3600;
+static const char *scaler;
+static int pace = PACE_UNTHROTTLED;
+static int probe;      // -l的间隔帧数
+static const char *loadFile, *saveFile;
+static const char *recordFile, *playFile;
+static long rewindKB;
+static long rewindBack;     // -b
+static long forks;          // -f
+static struct cowSnapshot **forked;
+static long forkedN;
+static double forkTime;
+static FILE *digestFile;    // -H
+static const char *profileFile; // -F
+static const char *opcodeFile;  // -O
+static const char *traceFile;   // -t
+static uint64_t digestChain;
+static long verify;         // -V
+static long checkEvery;     // -c
+static long nextAcquire;
+static unsigned long presentChecked, presentMismatches;
+static unsigned long verified, simdMismatches;
+static unsigned long cacheMismatches, cacheDeclined;
+static double cachedTime, plainTime;
+static FILE *out;
+static struct shmHeader *shm;
+
+static long frame;
+static long published;
+static double start;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void openShm(const char *name)
+{
+    size_t size = SHM_HEADER + (size_t)PRESENT_BUFFERS * SCREEN_BUFFER_SIZE;
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+    void *p;
+
+    if (fd < 0 || ftruncate(fd, size) != 0) {
+        perror("shm");
+        exit(1);
+    }
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+    shm = p;
+    memset(shm, 0, sizeof(*shm));
+    shm->buffers = PRESENT_BUFFERS;
+    shm->size = SCREEN_BUFFER_SIZE;
+}
+
+static void loadState(const char *name)
+{
+    FILE *f = fopen(name, "rb");
+    long size = stateSize();
+    unsigned char *buf = malloc(size + 1);
+    int err;
+
+    if (!f) {
+        perror(name);
+        exit(1);
+    }
+    size = (long)fread(buf, 1, size + 1, f);//多读一个字节：文件比当前格式长也照样交给stateRead
+    fclose(f);
+    err = stateRead(buf, size);
+    free(buf);
+    if (err) {
+        fprintf(stderr, "%s: bad state (%d)\n", name, err);
+        exit(1);
+    }
+}
+
+// 结束时存档，顺便测一下存档和读档（读回刚存的，状态不变）
+static void saveState(const char *name)
+{
+    long size = stateSize();
+    unsigned char *buf = malloc(size);
+    FILE *f;
+    double t0, t1, t2;
+    int n = 1000;
+
+    t0 = now();
+    for (int i = 0; i < n; i++) stateWrite(buf, size);
+    t1 = now();
+    for (int i = 0; i < n; i++) stateRead(buf, size);
+    t2 = now();
+    printf("state: %ld bytes, save %.1f us, load %.1f us\n", size, (t1 - t0) * 1e6 / n, (t2 - t1) * 1e6 / n);
+
+    f = fopen(name, "wb");
+    if (!f || fwrite(buf, 1, size, f) != (size_t)size) perror(name);
+    if (f) fclose(f);
+    free(buf);
+}
+
+int wnd_init(const char *filename)
+{
+    (void)filename;
+    hqxSetThreads((int)sysconf(_SC_NPROCESSORS_ONLN));//HQX按行带并行
+    if (screenInit(scaler, VIDEO_RGBA8888, shm ? (unsigned char *)shm + SHM_HEADER : NULL) != 0) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    paceInit(pace);
+    if (loadFile) loadState(loadFile);
+    if (recordFile && movieRecord() != 0) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    if (playFile) {
+        int err = moviePlay(playFile);
+        if (err) {
+            fprintf(stderr, "%s: bad movie (%d)\n", playFile, err);
+            exit(1);
+        }
+        frames = movieLength();
+    }
+    if (rewindKB && rewindInit(rewindKB * 1024, 1) != 0) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    if (traceFile && traceStart(traceFile) != 0) {
+        fprintf(stderr, "%s: can't trace (compile with -DVGB_TRACE)\n", traceFile);
+        exit(1);
+    }
+    start = now();
+    return 0;
+}
+
+// 取到的帧要和当前画面整帧重画的结果一样
+static void checkFrame(const struct presentFrame *f)
+{
+    static uint32_t src[SCREEN_WIDTH * SCREEN_HEIGHT];
+    static unsigned char ref[SCREEN_BUFFER_SIZE];
+    const struct scaler *s = scaler ? scalerFind(scaler) : NULL;
+    int rowBytes = f->width * videoBytesPerPixel(f->format);
+
+    if (s) {
+        videoConvert(getPixels(), src, VIDEO_RGBA8888, SCREEN_WIDTH * SCREEN_HEIGHT);
+        s->run(src, SCREEN_WIDTH * 4, (uint32_t *)ref, rowBytes, SCREEN_WIDTH, SCREEN_HEIGHT, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    } else {
+        videoConvert(getPixels(), ref, f->format, SCREEN_WIDTH * SCREEN_HEIGHT);
+    }
+    for (int y = 0; y < f->height; y++) {
+        if (memcmp(f->pixels + (long)y * f->stride, ref + (long)y * rowBytes, rowBytes)) {
+            if (!presentMismatches) printf("present: frame %ld (fence %lu) differs from a full redraw at row %d\n", frame, f->fence, y);
+            presentMismatches++;
+            break;
+        }
+    }
+    presentChecked++;
+}
+
+// 本进程自己当消费者：取最新帧交给文件或共享内存
+static void sink(void)
+{
+    struct presentFrame f;
+
+    if (checkEvery) {
+        if (frame < nextAcquire) return;
+        nextAcquire = frame + 1 + rand() % checkEvery;//不定期来取，缓冲要补画错过的几帧
+    }
+    if (!presentAcquire(&f)) return;
+    if (checkEvery) checkFrame(&f);
+    published++;
+    if (shm) {
+        shm->width = f.width;
+        shm->height = f.height;
+        shm->stride = f.stride;
+        shm->format = f.format;
+        shm->index = f.index;
+        __sync_synchronize();
+        shm->fence = f.fence;
+    }
+    if (out) {
+        for (int y = 0; y < f.height; y++) {
+            fwrite(f.pixels + (long)y * f.stride, 1, f.width * videoBytesPerPixel(f.format), out);
+        }
+    }
+}
+
+// 脚本按键，时间戳取当前时间，下一帧生效
+static void script(void)
+{
+    static const int keys[] = { INPUT_LEFT, INPUT_RIGHT };
+    static int presses, button;
+    
+    if (frame % probe == 0) {
+        button = presses < 3 ? INPUT_START : keys[presses % 2];
+        presses++;
+        inputPush(button, 1);
+    } else if (frame % probe == LATENCY_HOLD) {
+        inputPush(button, 0);
+    }
+}
+
+// 每帧一行：帧号 cpu memory frame all
+static void digestFrame(void)
+{
+    struct digest d;
+    uint64_t link[2];
+
+    digestCompute(&d);
+    link[0] = digestChain;
+    link[1] = d.all;
+    digestChain = hash64(link, sizeof(link), 0);
+    fprintf(digestFile, "%ld %016llx %016llx %016llx %016llx\n", frame, (unsigned long long)d.cpu,
+            (unsigned long long)d.memory, (unsigned long long)d.frame, (unsigned long long)d.all);
+}
+
+static uint32_t verifyA[SCREEN_WIDTH * SCALE_MAX * SCREEN_HEIGHT * SCALE_MAX];
+static uint32_t verifyB[SCREEN_WIDTH * SCALE_MAX * SCREEN_HEIGHT * SCALE_MAX];
+
+// 同一帧分别走SIMD和标量参考代码，输出要逐字节一致
+static void verifySimd(uint32_t *src)
+{
+    uint32_t *simd = verifyA, *scalar = verifyB;
+
+    for (int scale = 2; scale <= 4; scale++) {
+        uint32_t drb = SCREEN_WIDTH * scale * 4;
+
+        hqxSetSimd(1);
+        hqx_32_rb_parallel(scale, src, SCREEN_WIDTH * 4, simd, drb, SCREEN_WIDTH, SCREEN_HEIGHT);
+        hqxSetSimd(0);
+        hqx_32_rb_parallel(scale, src, SCREEN_WIDTH * 4, scalar, drb, SCREEN_WIDTH, SCREEN_HEIGHT);
+        if (memcmp(simd, scalar, (size_t)drb * SCREEN_HEIGHT * scale)) {
+            if (!simdMismatches) printf("verify: hq%dx SIMD differs from scalar at frame %ld\n", scale, frame);
+            simdMismatches++;
+        }
+    }
+    hqxSetSimd(1);
+}
+
+// hq2x的邻域缓存和普通路径（都在本线程跑），输出要逐字节一致
+static void verifyCache(uint32_t *src)
+{
+    uint32_t *cached = verifyA, *plain = verifyB;
+    uint32_t drb = SCREEN_WIDTH * 2 * 4;
+    double t0, t1, t2;
+
+    t0 = now();
+    if (!hq2x_32_rb_cached(src, SCREEN_WIDTH * 4, cached, drb, SCREEN_WIDTH, SCREEN_HEIGHT)) {
+        cacheDeclined++;//超过4种颜色
+        return;
+    }
+    t1 = now();
+    hq2x_32_rb(src, SCREEN_WIDTH * 4, plain, drb, SCREEN_WIDTH, SCREEN_HEIGHT);
+    t2 = now();
+    cachedTime += t1 - t0;
+    plainTime += t2 - t1;
+    if (memcmp(cached, plain, (size_t)drb * SCREEN_HEIGHT * 2)) {
+        if (!cacheMismatches) printf("verify: cached hq2x differs at frame %ld\n", frame);
+        cacheMismatches++;
+    }
+}
+
+static void verifyFrame(void)
+{
+    static uint32_t src[SCREEN_WIDTH * SCREEN_HEIGHT];
+
+    videoConvert(getPixels(), src, VIDEO_RGBA8888, SCREEN_WIDTH * SCREEN_HEIGHT);
+    verifySimd(src);
+    verifyCache(src);
+    verified++;
+}
+
+void wnd_draw(uint8_t* pixels)
+{
+    (void)pixels;//帧从screen.c走呈现缓冲
+    if (digestFile) digestFrame();
+    if (verify && frame % verify == 0) verifyFrame();
+    if (forkedN < forks) {
+        double t = now();
+        forked[forkedN] = cowFork();
+        forkTime += now() - t;
+        if (forked[forkedN]) forkedN++;
+    }
+    frame++;
+    screenFrame();
+    sink();
+    if (probe) script();
+    paceFrame();
+}
+
+int wnd_updateEvent(void)
+{
+    if (rewindBack) vmainSetRewind(frame >= frames - rewindBack);
+    return frame >= frames;
+}
+
+static void rewindReport(void)
+{
+    struct rewindStats s;
+
+    rewindGetStats(&s);
+    printf("rewind: %lu captures (%lu keyframes, %ld bytes; deltas %ld bytes), capture %.2f us, max %.1f us\n",
+           s.captures, s.keyframes, s.keyBytes, s.deltaBytes, s.captureUs, s.maxCaptureUs);
+    printf("  %.0f KB per minute, %d entries %ld/%ld KB (%.1f s), %lu dropped, %lu steps %.2f us\n",
+           s.minuteBytes / 1024.0, s.entries, s.bytes / 1024, s.budget / 1024, rewindFrames() / PACE_HZ,
+           s.dropped, s.steps, s.stepUs);
+}
+
+static void digestReport(void)
+{
+    struct digestStats s;
+
+    digestGetStats(&s);
+    printf("digest: %lu frames, chain %016llx, %.2f us/frame, %.1f pages hashed per frame\n",
+           s.computed, (unsigned long long)digestChain, s.seconds * 1e6 / s.computed,
+           (double)s.pagesHashed / s.computed);
+}
+
+// 编译时定义了VGB_STATS才有
+static void countersReport(void)
+{
+    struct counters c;
+    unsigned long long reads = 0, writes = 0;
+    unsigned char used[0x100] = { 0 };
+
+    if (countersGet(&c) != 0 || !frame) return;
+    for (int r = 0; r < COUNTER_REGIONS; r++) {
+        reads += c.reads[r];
+        writes += c.writes[r];
+    }
+    printf("counters per frame: %.0f read8, %.0f write8, %.0f interruptCycle\n",
+           (double)reads / frame, (double)writes / frame, (double)c.interruptCycles / frame);
+    printf("  region   read8  write8\n");
+    for (int r = 0; r < COUNTER_REGIONS; r++) {
+        printf("  %-6s %7.0f %7.0f\n", counterRegionName(r), (double)c.reads[r] / frame, (double)c.writes[r] / frame);
+    }
+    // 访问最多的8个I/O寄存器
+    printf("  io       read8  write8\n");
+    for (int i = 0; i < 8; i++) {
+        int best = -1;
+        for (int a = 0; a < 0x100; a++) {
+            unsigned long long n = c.ioReads[a] + c.ioWrites[a];
+            if (!used[a] && n && (best < 0 || n > c.ioReads[best] + c.ioWrites[best])) best = a;
+        }
+        if (best < 0) break;
+        used[best] = 1;
+        printf("  FF%02X   %7.0f %7.0f\n", best, (double)c.ioReads[best] / frame, (double)c.ioWrites[best] / frame);
+    }
+    printf("  renderLine %.2f us/frame (%llu lines, %.3f us each), draw %.2f us/frame (%llu frames), sleep %.3f ms/frame\n",
+           c.lineSeconds * 1e6 / frame, c.lines, c.lines ? c.lineSeconds * 1e6 / c.lines : 0,
+           c.drawSeconds * 1e6 / frame, c.draws, c.sleepSeconds * 1e3 / frame);
+}
+
+// 没有编译进来时返回-1
+static int writeFile(const char *name, int (*write)(FILE *f))
+{
+    FILE *f = fopen(name, "w");
+    int err;
+
+    if (!f) {
+        perror(name);
+        return 0;
+    }
+    err = write(f);
+    fclose(f);
+    return err;
+}
+
+static int writeOpcodes(FILE *f)
+{
+    return profileWriteOpcodes(f, 50);
+}
+
+static void traceReport(void)
+{
+    struct traceStats s;
+
+    traceStop();
+    traceGetStats(&s);
+    printf("trace: %llu records, %.1f MB, %llu writes, %llu stalls\n",
+           s.records, s.records * TRACE_RECORD / 1048576.0, s.writes, s.stalls);
+}
+
+static void fuseReport(void)
+{
+    struct fuseStats s;
+    unsigned long long groups = 0;
+
+    fuseGetStats(&s);
+    for (int i = 0; i < FUSE_PATTERNS; i++) groups += s.groups[i];
+    if (!groups) return;
+    printf("fuse: %llu instructions in %llu groups, %.0f dispatches saved per frame, %llu declined\n",
+           s.instructions, groups, (double)(s.instructions - groups) / frame, s.declined);
+    for (int i = 0; i < FUSE_PATTERNS; i++) {
+        if (s.groups[i]) printf("  %12llu  %s\n", s.groups[i], fuseName(i));
+    }
+}
+
+static void profileReport(void)
+{
+    int err = 0;
+
+    if (profileFile) err |= profileWriteFlat(stdout, 20) | writeFile(profileFile, profileWriteFolded);
+    if (opcodeFile) err |= writeFile(opcodeFile, writeOpcodes);
+    if (err) printf("profile: not built in, compile with -DVGB_PROFILE\n");
+}
+
+static int movieReport(void)
+{
+    struct movieStats s;
+    int err;
+
+    if (recordFile) {
+        err = movieSave(recordFile);
+        movieGetStats(&s);
+        if (err) fprintf(stderr, "%s: write failed (%d)\n", recordFile, err);
+        else printf("movie: recorded %lu frames, %lu events\n", s.frames, s.events);
+        return err != 0;
+    }
+    movieGetStats(&s);
+    printf("movie: played %lu/%lu frames, %lu events, %lu checked, %lu mismatches",
+           s.frames, movieLength(), s.events, s.checked, s.mismatches);
+    if (s.mismatches) printf(" (first at frame %ld)", s.firstMismatch);
+    if (!s.checked && movieLength()) printf(" (nothing compared)");
+    printf("\n");
+    return s.mismatches != 0 || s.frames != movieLength() || (!s.checked && movieLength());
+}
+
+static int forkReport(void)
+{
+    struct cowStats s;
+    struct digest cached, rehashed;
+    int status = 0;
+    struct machineState *full = malloc(sizeof(*full));
+    double t0, t1, t2;
+    int n = 1000;
+
+    cowGetStats(&s);
+    printf("cow: %lu forks, %.2f us, %.1f pages copied per fork; %lu snapshots share %lu pages (%lu KB, full copies %lu KB)\n",
+           s.forks, forkTime * 1e6 / forkedN, (double)s.pagesCopied / s.forks, s.snapshots, s.pagesInUse,
+           s.pagesInUse * MEM_PAGE / 1024, s.snapshots * (unsigned long)sizeof(*full) / 1024);
+    if (forkedN < 2) {
+        free(full);
+        return 0;
+    }
+
+    // 在最后两帧的快照之间来回切换
+    cowResetStats();
+    t0 = now();
+    for (int i = 0; i < n; i++) cowRestore(forked[forkedN - 1 - (i & 1)]);
+    t1 = now();
+    for (int i = 0; i < n; i++) {
+        stateSave(full);
+        stateLoad(full);
+    }
+    t2 = now();
+    cowGetStats(&s);
+    printf("  restore %.2f us, %.1f pages; full save+load %.2f us\n",
+           (t1 - t0) * 1e6 / n, (double)s.pagesRestored / n, (t2 - t1) * 1e6 / n);
+
+    // 回滚到第一个快照，摘要要和全部重新算的一样（回滚的页要让digest.c重新算）
+    digestCompute(&cached);
+    cowRestore(forked[0]);
+    digestCompute(&cached);
+    memTouchAll();
+    digestCompute(&rehashed);
+    printf("  restore digest %016llx, full rehash %016llx: %s\n", (unsigned long long)cached.all,
+           (unsigned long long)rehashed.all, cached.all == rehashed.all ? "ok" : "MISMATCH");
+    if (cached.all != rehashed.all) status = 1;
+
+    cowRestore(forked[forkedN - 1]);
+    for (long i = 0; i < forkedN; i++) cowRelease(forked[i]);
+    free(full);
+    return status;
+}
+
+int main(int argc, char **argv)
+{
+    const char *rom = NULL;
+    const char *shmName = NULL;
+    struct presentStats stats;
+    double t;
+    int status = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) frames = atol(argv[++i]);
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc) scaler = argv[++i];
+        else if (!strcmp(argv[i], "-p") && i + 1 < argc) pace = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc) vmainSetRunAhead(atoi(argv[++i]));
+        else if (!strcmp(argv[i], "-l") && i + 1 < argc) probe = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-L") && i + 1 < argc) loadFile = argv[++i];
+        else if (!strcmp(argv[i], "-S") && i + 1 < argc) saveFile = argv[++i];
+        else if (!strcmp(argv[i], "-w") && i + 1 < argc) rewindKB = atol(argv[++i]);
+        else if (!strcmp(argv[i], "-b") && i + 1 < argc) rewindBack = atol(argv[++i]);
+        else if (!strcmp(argv[i], "-f") && i + 1 < argc) forks = atol(argv[++i]);
+        else if (!strcmp(argv[i], "-R") && i + 1 < argc) recordFile = argv[++i];
+        else if (!strcmp(argv[i], "-P") && i + 1 < argc) playFile = argv[++i];
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) traceFile = argv[++i];
+        else if (!strcmp(argv[i], "-u") && i + 1 < argc) fuseSetEnabled(atoi(argv[++i]));
+        else if (!strcmp(argv[i], "-F") && i + 1 < argc) profileFile = argv[++i];
+        else if (!strcmp(argv[i], "-O") && i + 1 < argc) opcodeFile = argv[++i];
+        else if (!strcmp(argv[i], "-H") && i + 1 < argc) digestFile = fopen(argv[++i], "w");
+        else if (!strcmp(argv[i], "-V") && i + 1 < argc) verify = atol(argv[++i]);
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc) checkEvery = atol(argv[++i]);
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) out = fopen(argv[++i], "wb");
+        else if (!strcmp(argv[i], "-m") && i + 1 < argc) shmName = argv[++i];
+        else rom = argv[i];
+    }
+    if (!rom) {
+        fprintf(stderr, "usage: %s rom.gb [-n frames] [-s scaler] [-p pace] [-r frames] [-l interval] [-L state] [-S state] [-w KB [-b frames]] [-f frames] [-R movie | -P movie] [-V interval] [-c N] [-H digests] [-t trace] [-u 0|1] [-F folded] [-O opcodes] [-o file | -m shm]\n", argv[0]);
+        return 1;
+    }
+    if (scaler && !scalerFind(scaler)) {
+        fprintf(stderr, "unknown scaler %s\n", scaler);
+        return 1;
+    }
+    if (probe && probe <= LATENCY_HOLD) {
+        fprintf(stderr, "latency interval must be more than %d frames\n", LATENCY_HOLD);
+        return 1;
+    }
+    if (shmName) openShm(shmName);
+    if (forks) forked = calloc(forks, sizeof(*forked));
+    latencyEnable(probe > 0);
+
+    vmain((int)strlen(rom), rom);
+
+    t = now() - start;
+    printf("%ld frames, %ld presented, %.3f s, %.1f fps, %.0f ns/frame\n",
+           frame, published, t, frame / t, t * 1e9 / frame);
+    presentGetStats(&stats);
+    printf("present: %lu published, %lu consumed, %lu dropped, %lu duplicated\n",
+           stats.published, stats.consumed, stats.dropped, stats.duplicated);
+    if (checkEvery) {
+        printf("present: %lu frames checked against a full redraw, %lu mismatches\n", presentChecked, presentMismatches);
+        if (presentMismatches) status = 1;
+    }
+    if (probe) latencyReport(stdout);
+    if (rewindKB) rewindReport();
+    if (forkedN && forkReport()) status = 1;
+    if ((recordFile || playFile) && movieReport()) status = 1;
+    if (traceFile) traceReport();
+    if (verify) {
+        unsigned long cached = verified - cacheDeclined;
+
+        printf("verify: %lu frames, hq2x/hq3x/hq4x SIMD vs scalar %lu mismatches\n", verified, simdMismatches);
+        printf("  hq2x cached vs plain: %lu frames, %lu mismatches, %lu declined; %.1f us vs %.1f us per frame (%.1fx)\n",
+               cached, cacheMismatches, cacheDeclined, cached ? cachedTime * 1e6 / cached : 0,
+               cached ? plainTime * 1e6 / cached : 0, cachedTime > 0 ? plainTime / cachedTime : 0);
+        if (simdMismatches || cacheMismatches) status = 1;
+    }
+    fuseReport();
+    countersReport();
+    if (profileFile || opcodeFile) profileReport();
+    if (digestFile) {
+        digestReport();
+        fclose(digestFile);
+    }
+    if (saveFile) saveState(saveFile);
+    if (out) fclose(out);
+    return status;
+}
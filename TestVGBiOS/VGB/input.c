@@ -0,0 +1,282 @@
+//
+//  input.c
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+/*
+ 按键输入。
+
+ 宿主线程把带时间戳的事件放进单生产者单消费者的无锁环形队列，模拟线程在
+ 每帧开始时(inputFrame)取走。模拟是按帧成批跑完再等待的，所以把上一帧的
+ 真实时间段[上一帧开始, 本帧开始)按比例映射到本帧的周期上：事件固定晚一帧
+ 生效，但帧内的先后和间隔保留下来，生效的周期只由时间戳决定。
+
+ 按下时如果对应的一组已经选中，P10-P13由高变低，触发JOYPAD中断（切换选择
+ 时同理）。很快的点按可能在游戏读寄存器之前就松开了，所以松开要等游戏在选中
+ 那一组时读到过按下才生效，最多推迟两帧。
+ */
+
+#include "input.h"
+
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+
+#include "cpu.h"
+#include "interrupt.h"
+#include "latency.h"
+#include "movie.h"
+
+#define FRAME_CYCLES    (70224/4)
+
+struct inputEvent {
+    int64_t time;
+    unsigned int cycle;     // 模拟线程排好的生效周期
+    uint8_t button;
+    uint8_t down;
+};
+
+// 宿主 -> 模拟线程
+static struct inputEvent queue[INPUT_QUEUE];
+static atomic_uint head, tail;
+static atomic_ulong overflow;
+
+// 以下只有模拟线程访问
+static struct inputEvent pending[INPUT_QUEUE];
+static int pendingHead, pendingN;
+static int64_t frameTime;   // 本帧开始的真实时间
+
+static uint8_t buttons;     // 按下为1
+static uint8_t selectBits;  // 0xFF00的P14/P15，为0时选中
+static uint8_t lines;       // 当前拉低的P10-P13
+static uint8_t seen;        // 按下之后游戏读到过
+static uint8_t held, heldOld;   // 推迟的松开，heldOld是上一帧就推迟了的
+
+static struct inputStats stats;
+static unsigned long lagN;
+
+// run-ahead：超前的帧读档后会重跑，事件生效但不录像、不测延迟、不计数
+static int ahead;
+static struct inputStats aheadStats;
+
+int64_t inputNow(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void inputPushAt(int button, int down, int64_t time)
+{
+    unsigned int h = atomic_load_explicit(&head, memory_order_relaxed);
+    struct inputEvent *e;
+
+    if (h - atomic_load_explicit(&tail, memory_order_acquire) >= INPUT_QUEUE) {
+        atomic_fetch_add_explicit(&overflow, 1, memory_order_relaxed);
+        return;
+    }
+    e = &queue[h % INPUT_QUEUE];
+    e->time = time;
+    e->button = button & 7;
+    e->down = down != 0;
+    atomic_store_explicit(&head, h + 1, memory_order_release);
+}
+
+void inputPush(int button, int down)
+{
+    inputPushAt(button, down, inputNow());
+}
+
+// 当前拉低的输入线
+static uint8_t lowLines(void)
+{
+    uint8_t low = 0;
+    if (!(selectBits & 0x10)) low |= buttons & 0x0F;
+    if (!(selectBits & 0x20)) low |= buttons >> 4;
+    return low;
+}
+
+static void update(void)
+{
+    uint8_t low = lowLines();
+    if (low & ~lines) {
+        interrupt.flags |= JOYPAD;
+        stats.interrupts++;
+    }
+    lines = low;
+}
+
+static void release(uint8_t bits)
+{
+    buttons &= ~bits;
+    held &= ~bits;
+    heldOld &= ~bits;
+}
+
+static void apply(const struct inputEvent *e, int late)
+{
+    uint8_t bit = 1 << e->button;
+
+    if (e->down) {
+        buttons |= bit;
+        seen &= ~bit;
+        held &= ~bit;
+        heldOld &= ~bit;
+        if (!ahead) latencyInput(e->time);
+    } else if (buttons & bit) {
+        if (seen & bit) {
+            release(bit);
+        } else if (!(held & bit)) {
+            held |= bit;
+            stats.held++;
+        }
+    }
+    stats.events++;
+    if (!ahead) movieInput(e->button, e->down, late);
+    update();
+}
+
+void inputInit(void)
+{
+    atomic_store(&tail, atomic_load(&head));
+    pendingHead = pendingN = 0;
+    frameTime = 0;
+    buttons = selectBits = lines = seen = held = heldOld = 0;
+    inputResetStats();
+}
+
+void inputFrame(void)
+{
+    int64_t t = inputNow(), span = frameTime ? t - frameTime : 0;
+    unsigned int c = getCycles();
+    unsigned int h = atomic_load_explicit(&head, memory_order_acquire);
+    unsigned int tl = atomic_load_explicit(&tail, memory_order_relaxed);
+
+    // 上一帧没来得及生效的（周期被截断在帧末，一般不会有）
+    for (; pendingN; pendingN--) apply(&pending[pendingHead++], 1);
+    pendingHead = 0;
+
+    // 推迟了一整帧游戏还没读，不再等
+    if (heldOld) {
+        release(heldOld);
+        update();
+    }
+    heldOld = held;
+
+    movieFrame();
+    if (moviePlaying()) {
+        // 回放：宿主的按键丢掉，事件按录像里的周期排
+        int button, down;
+        unsigned int cycle;
+
+        while (pendingN < INPUT_QUEUE && movieEvent(&button, &down, &cycle)) {
+            struct inputEvent *e = &pending[pendingN++];
+            e->time = 0;
+            e->cycle = cycle;
+            e->button = button;
+            e->down = down;
+        }
+        tl = h;
+    }
+
+    for (; tl != h; tl++) {
+        struct inputEvent *e = &pending[pendingN++];
+        int64_t d;
+
+        *e = queue[tl % INPUT_QUEUE];
+        d = span > 0 ? e->time - frameTime : 0;
+        if (d < 0) d = 0;
+        if (d >= span) d = span > 0 ? span - 1 : 0;
+        e->cycle = c + (span > 0 ? (unsigned int)(d * FRAME_CYCLES / span) : 0);
+
+        double lag = (t - e->time) / 1e6;
+        stats.meanLagMs += (lag - stats.meanLagMs) / ++lagN;
+        if (lag > stats.maxLagMs) stats.maxLagMs = lag;
+    }
+    atomic_store_explicit(&tail, tl, memory_order_release);
+
+    frameTime = t;
+    inputCycle();
+}
+
+void inputCycle(void)
+{
+    while (pendingN && (int)(getCycles() - pending[pendingHead].cycle) >= 0) {
+        apply(&pending[pendingHead], 0);
+        pendingHead++;
+        pendingN--;
+    }
+}
+
+int inputDue(unsigned int cycles)
+{
+    return pendingN && (int)(cycles - pending[pendingHead].cycle) >= 0;
+}
+
+unsigned char inputRead(void)
+{
+    unsigned char value = 0xC0 | selectBits | (0x0F ^ lowLines());
+    uint8_t r;
+
+    if (!(selectBits & 0x10)) seen |= buttons & 0x0F;
+    if (!(selectBits & 0x20)) seen |= buttons & 0xF0;
+    r = held & seen;
+    if (r) {
+        release(r);
+        update();
+    }
+    return value;
+}
+
+void inputWrite(unsigned char value)
+{
+    selectBits = value & 0x30;
+    update();
+}
+
+void inputSetAhead(int on)
+{
+    if (on && !ahead) aheadStats = stats;
+    if (!on && ahead) stats = aheadStats;
+    ahead = on;
+}
+
+void inputSaveState(struct inputState *state)
+{
+    state->buttons = buttons;
+    state->select = selectBits;
+    state->lines = lines;
+    state->seen = seen;
+    state->held = held;
+    state->heldOld = heldOld;
+    state->pendingHead = pendingHead;
+    state->pendingN = pendingN;
+}
+
+void inputLoadState(const struct inputState *state)
+{
+    buttons = state->buttons;
+    selectBits = state->select;
+    lines = state->lines;
+    seen = state->seen;
+    held = state->held;
+    heldOld = state->heldOld;
+    pendingHead = state->pendingHead;
+    pendingN = state->pendingN;
+}
+
+void inputGetStats(struct inputStats *s)
+{
+    *s = stats;
+    s->overflow = atomic_load_explicit(&overflow, memory_order_relaxed);
+}
+
+void inputResetStats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+    lagN = 0;
+    atomic_store(&overflow, 0);
+}
@@ -0,0 +1,73 @@
+//
+//  input.h
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+#ifndef input_h
+#define input_h
+
+#include <stdint.h>
+
+// 按键编号，也是joypad状态里的位：0-3方向(P10-P13)，4-7按键
+#define INPUT_RIGHT     0
+#define INPUT_LEFT      1
+#define INPUT_UP        2
+#define INPUT_DOWN      3
+#define INPUT_A         4
+#define INPUT_B         5
+#define INPUT_SELECT    6
+#define INPUT_START     7
+
+#define INPUT_QUEUE     64  // 每帧最多排队的事件
+
+// 存档用：joypad的状态和本帧还没生效的事件位置
+struct inputState {
+    uint8_t buttons;
+    uint8_t select;
+    uint8_t lines;
+    uint8_t seen;
+    uint8_t held;
+    uint8_t heldOld;
+    int pendingHead;
+    int pendingN;
+};
+
+struct inputStats {
+    unsigned long events;       // 已生效的事件
+    unsigned long overflow;     // 队列满丢掉的事件
+    unsigned long held;         // 游戏还没读到按下，推迟的松开
+    unsigned long interrupts;   // 触发的JOYPAD中断
+    double meanLagMs;           // 事件时间戳到帧开始取走它的间隔
+    double maxLagMs;
+};
+
+// 宿主线程（单生产者），不阻塞；time为CLOCK_MONOTONIC纳秒
+void inputPush(int button, int down);
+void inputPushAt(int button, int down, int64_t time);
+int64_t inputNow(void);
+
+// 以下在模拟线程
+void inputInit(void);
+void inputFrame(void);  // 帧开始：取走队列里的事件，按时间戳排到本帧的周期上
+void inputCycle(void);  // 主循环里每条指令后调用，到了周期的事件生效
+int inputDue(unsigned int cycles);  // 到cycles（含）为止有事件要生效
+
+// joypad寄存器(0xFF00)
+unsigned char inputRead(void);
+void inputWrite(unsigned char value);
+
+// 读档时本帧已经取出的事件还在，只恢复读到哪里（run-ahead读档后按原来的周期重新生效）
+void inputSaveState(struct inputState *state);
+void inputLoadState(const struct inputState *state);
+
+// run-ahead超前的帧之间传1：事件照常生效，但不调用movieInput/latencyInput，
+// 统计在传0时恢复原样（读档后这些事件还会真正生效一次）
+void inputSetAhead(int on);
+
+void inputGetStats(struct inputStats *stats);
+void inputResetStats(void);
+
+#endif /* input_h */
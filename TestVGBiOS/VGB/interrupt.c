@@ -7,12 +7,14 @@
 //
 
 #include "interrupt.h"
+#include "counters.h"
 #include "cpu.h"
 
 struct interrupt interrupt;
 
 void interruptCycle()
 {
+    COUNT(interruptCycles);
     if (interrupt.pending == 1) {
         interrupt.pending -= 1;
         return;
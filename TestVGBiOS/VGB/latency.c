@@ -0,0 +1,190 @@
+//
+//  latency.c
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+/*
+ 输入延迟测量。
+
+ 一次只测一个按下：按下在模拟里生效后，等第一帧画面有变化的帧（lcd有变化
+ 区域、screen发布了新帧），记下经过的帧数和从事件时间戳到发布的时间；再等
+ 宿主取到这一帧（presentAcquire），记下到“上屏”的时间。画面变化不一定都是
+ 按键引起的，所以脚本要在画面静止的时候按。
+
+ 发布在模拟线程，取帧在宿主线程，两边只通过target/photon两个原子量交接。
+ */
+
+#include "latency.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define PHOTON_TIMEOUT  10  // 发布之后这么多帧宿主还没取走，不记上屏时间
+
+struct sample {
+    int frames;
+    float publishMs;
+    float photonMs;     // 没有取走时为-1
+};
+
+static atomic_int enabled;
+
+// 以下只有模拟线程访问
+static int state;       // 0空闲 1等画面变化 2等宿主取帧
+static int64_t stamp, publishTime;
+static unsigned long frame, startFrame, changedFrame;
+static struct sample samples[LATENCY_SAMPLES];
+static struct latencyStats stats;
+
+// 宿主线程写
+static atomic_ulong target;
+static atomic_ulong photonFence;
+static atomic_llong photonTime;
+
+static int64_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void latencyEnable(int on)
+{
+    atomic_store(&enabled, on);
+}
+
+int latencyEnabled(void)
+{
+    return atomic_load_explicit(&enabled, memory_order_relaxed);
+}
+
+void latencyInput(int64_t t)
+{
+    if (!latencyEnabled()) return;
+    if (state) {
+        if (t == stamp) return;//run-ahead读档后同一个事件再生效一次
+        stats.overlapped++;
+        return;
+    }
+    state = 1;
+    stamp = t;
+    startFrame = frame;
+}
+
+static void record(int64_t photon)
+{
+    struct sample *s;
+
+    if (stats.samples < LATENCY_SAMPLES) {
+        s = &samples[stats.samples];
+        s->frames = (int)(changedFrame - startFrame);
+        s->publishMs = (publishTime - stamp) / 1e6;
+        s->photonMs = photon ? (photon - stamp) / 1e6 : -1;
+    }
+    stats.histogram[changedFrame - startFrame < LATENCY_MAX_FRAMES ? changedFrame - startFrame : LATENCY_MAX_FRAMES - 1]++;
+    stats.samples++;
+}
+
+void latencyFrame(unsigned long fence)
+{
+    frame++;
+    if (!latencyEnabled()) return;
+
+    if (state == 1) {
+        if (fence) {
+            publishTime = now();
+            changedFrame = frame;
+            atomic_store_explicit(&target, fence, memory_order_release);
+            state = 2;
+        } else if (frame - startFrame > LATENCY_TIMEOUT) {
+            stats.noResponse++;
+            state = 0;
+        }
+    } else if (state == 2) {
+        unsigned long t = atomic_load_explicit(&target, memory_order_relaxed);
+        if (atomic_load_explicit(&photonFence, memory_order_acquire) == t) {
+            record(atomic_load_explicit(&photonTime, memory_order_relaxed));
+        } else if (frame - changedFrame > PHOTON_TIMEOUT) {
+            record(0);
+        } else {
+            return;
+        }
+        atomic_store_explicit(&target, 0, memory_order_relaxed);
+        state = 0;
+    }
+}
+
+void latencyAcquired(unsigned long fence)
+{
+    unsigned long t;
+
+    if (!latencyEnabled()) return;
+    t = atomic_load_explicit(&target, memory_order_acquire);
+    if (t && fence >= t && atomic_load_explicit(&photonFence, memory_order_relaxed) != t) {
+        atomic_store_explicit(&photonTime, now(), memory_order_relaxed);
+        atomic_store_explicit(&photonFence, t, memory_order_release);
+    }
+}
+
+static int compare(const void *a, const void *b)
+{
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+// p50 p95 max，跳过负数（没有取走的）
+static void percentiles(float *v, int n, double *out)
+{
+    int k = 0;
+
+    for (int i = 0; i < n; i++) if (v[i] >= 0) v[k++] = v[i];
+    out[0] = out[1] = out[2] = 0;
+    if (!k) return;
+    qsort(v, k, sizeof(*v), compare);
+    out[0] = v[k / 2];
+    out[1] = v[(k * 95) / 100 < k ? (k * 95) / 100 : k - 1];
+    out[2] = v[k - 1];
+}
+
+void latencyGetStats(struct latencyStats *s)
+{
+    static float v[LATENCY_SAMPLES];
+    int n = stats.samples < LATENCY_SAMPLES ? (int)stats.samples : LATENCY_SAMPLES;
+
+    *s = stats;
+    for (int i = 0; i < n; i++) v[i] = samples[i].publishMs;
+    percentiles(v, n, s->publishMs);
+    for (int i = 0; i < n; i++) v[i] = samples[i].photonMs;
+    percentiles(v, n, s->photonMs);
+}
+
+void latencyReport(FILE *out)
+{
+    struct latencyStats s;
+    unsigned long peak = 1;
+
+    latencyGetStats(&s);
+    fprintf(out, "latency: %lu samples, %lu no response, %lu overlapped\n", s.samples, s.noResponse, s.overlapped);
+    if (!s.samples) return;
+    for (int i = 0; i < LATENCY_MAX_FRAMES; i++) if (s.histogram[i] > peak) peak = s.histogram[i];
+    for (int i = 1; i < LATENCY_MAX_FRAMES; i++) {
+        if (!s.histogram[i]) continue;
+        fprintf(out, "  %2d%s frames %6lu ", i, i == LATENCY_MAX_FRAMES - 1 ? "+" : " ", s.histogram[i]);
+        for (unsigned long j = 0; j < s.histogram[i] * 40 / peak; j++) fputc('#', out);
+        fputc('\n', out);
+    }
+    fprintf(out, "  publish ms: p50 %.2f p95 %.2f max %.2f\n", s.publishMs[0], s.publishMs[1], s.publishMs[2]);
+    fprintf(out, "  photon  ms: p50 %.2f p95 %.2f max %.2f\n", s.photonMs[0], s.photonMs[1], s.photonMs[2]);
+}
+
+void latencyReset(void)
+{
+    memset(&stats, 0, sizeof(stats));
+    state = 0;
+    atomic_store(&target, 0);
+}
@@ -0,0 +1,42 @@
+//
+//  latency.h
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+#ifndef latency_h
+#define latency_h
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define LATENCY_SAMPLES     4096
+#define LATENCY_MAX_FRAMES  16  // 直方图的帧数桶，最后一个桶包含更多的
+#define LATENCY_TIMEOUT     60  // 超过这么多帧画面都没变化，算无响应
+
+struct latencyStats {
+    unsigned long samples;
+    unsigned long noResponse;   // 超时没有画面变化
+    unsigned long overlapped;   // 上一次测量没结束时的按下，不测
+    unsigned long histogram[LATENCY_MAX_FRAMES];    // 按下到画面变化的帧数
+    double publishMs[3];        // 时间戳到这一帧发布：p50 p95 max
+    double photonMs[3];         // 时间戳到宿主取走这一帧
+};
+
+// 默认关闭，关闭时下面的钩子直接返回
+void latencyEnable(int on);
+int latencyEnabled(void);
+
+// 钩子：按下生效时(input.c)、每帧结束时(screen.c，fence为本帧发布的序号，没有发布为0)、
+// 宿主取到帧时(present.c，消费者线程)
+void latencyInput(int64_t stamp);
+void latencyFrame(unsigned long fence);
+void latencyAcquired(unsigned long fence);
+
+void latencyGetStats(struct latencyStats *stats);
+void latencyReport(FILE *out);
+void latencyReset(void);
+
+#endif /* latency_h */
@@ -8,9 +8,15 @@
 
 #include "lcd.h"
 
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "counters.h"
 #include "cpu.h"
 #include "interrupt.h"
 #include "mmu.h"
+#include "video.h"
 
 struct LCD LCD;
 struct LCDC LCDC;
@@ -22,6 +28,45 @@ int spritePalette1[] = {0, 1, 2, 3};
 int spritePalette2[] = {0, 1, 2, 3};
 unsigned int colours[4] = {0xFFFFFF, 0xC0C0C0, 0x808080, 0x000000};
 
+// 索引帧缓冲，呈现时再由video.c转换成RGB
+static unsigned char pixels[160*144];
+
+// 调色板寄存器原始值（脏行检测用）
+static unsigned char bgpReg, obp0Reg, obp1Reg;
+
+// 每行渲染时的寄存器快照，输入不变且VRAM/OAM未改动的行跳过渲染
+struct lineState {
+    unsigned char lcdc;
+    unsigned char scx;
+    unsigned char scy;
+    unsigned char wx;
+    unsigned char wy;
+    unsigned char bgp;
+    unsigned char obp0;
+    unsigned char obp1;
+};
+
+static struct lineState lineStates[144];
+static unsigned char lineClean[144]; // 0 = 需要重新渲染
+static unsigned char lineForce[144]; // 1 = 整行都算变化（输出目标换了）
+static int frameDirty;
+
+// 本帧每行实际变化的像素区间[spanX0, spanX1)，spanX1为0表示没变
+static unsigned char spanX0[144], spanX1[144];
+
+// 跳帧：CPU/中断时序照常，只是不生成像素
+// 前两个由宿主线程写，模拟线程只在VBlank（nextFrame）读
+static atomic_int frameSkip;    // 每frameSkip+1帧渲染一帧，LCD_SKIP_ON_DEMAND为按需
+static atomic_int frameRequest; // 宿主请求渲染下一帧
+static int frameSkipped;    // 当前帧是否跳过
+
+static int prevLine;        // 上次lcdCycle时的扫描行
+
+// 上次lcdSaveState之后改过的行，读回这份存档时只有它们要重画
+static unsigned char lineTouched[144];
+static int vramTouched;     // 改过显存：按渲染时的寄存器才知道影响哪些行，读档时全部重画
+static unsigned int saveSerial;
+
 //////////////////////////////////////////////////
 
 // 获取或设置lcd寄存器
@@ -59,6 +104,7 @@ unsigned char getLCDS(void)
 
 void setBGPalette(unsigned char value)
 {
+    bgpReg = value;
     bgPalette[3] = ((value >> 6) & 0x03);
     bgPalette[2] = ((value >> 4) & 0x03);
     bgPalette[1] = ((value >> 2) & 0x03);
@@ -67,6 +113,7 @@ void setBGPalette(unsigned char value)
 
 void setSpritePalette1(unsigned char value)
 {
+    obp0Reg = value;
     spritePalette1[3] = ((value >> 6) & 0x03);
     spritePalette1[2] = ((value >> 4) & 0x03);
     spritePalette1[1] = ((value >> 2) & 0x03);
@@ -75,6 +122,7 @@ void setSpritePalette1(unsigned char value)
 
 void setSpritePalette2(unsigned char value)
 {
+    obp1Reg = value;
     spritePalette2[3] = ((value >> 6) & 0x03);
     spritePalette2[2] = ((value >> 4) & 0x03);
     spritePalette2[1] = ((value >> 2) & 0x03);
@@ -123,6 +171,159 @@ void setLyCompare(unsigned char value)
 
 /////////////////////////////////////////////////////////////////////////
 
+// 脏行标记
+void lcdInvalidate(void)
+{
+    memset(lineClean, 0, sizeof(lineClean));
+    memset(lineForce, 1, sizeof(lineForce));
+}
+
+void lcdTouchVram(unsigned short address)
+{
+    int map, row;
+    
+    vramTouched = 1;
+    if (address < 0x9800) {
+        // tile data: 无法廉价地知道哪些行引用了该tile，全部重画
+        memset(lineClean, 0, sizeof(lineClean));
+        return;
+    }
+    
+    // tile map: 只标记按快照寄存器会读到该map行的屏幕行
+    map = (address - 0x9800) / 0x400;
+    row = ((address - 0x9800) % 0x400) / 32;
+    for (int line = 0; line < 144; line++) {
+        struct lineState *st = &lineStates[line];
+        if (!lineClean[line]) continue;
+        if (!!(st->lcdc & 0x08) == map && ((line + st->scy) % 256) / 8 == row)
+            lineClean[line] = 0;
+        if ((st->lcdc & 0x20) && !!(st->lcdc & 0x40) == map && line >= st->wy && (line - st->wy) / 8 == row)
+            lineClean[line] = 0;
+    }
+}
+
+static void touchSpriteLines(int y)
+{
+    // 按8x16精灵保守标记
+    for (int line = y - 16; line < y; line++) {
+        if (line >= 0 && line < 144) {
+            lineClean[line] = 0;
+            lineTouched[line] = 1;
+        }
+    }
+}
+
+void lcdTouchOam(unsigned short address, unsigned char old)
+{
+    int i = (address - 0xFE00) / 4;
+    
+    if (i >= 40) return;
+    
+    if ((address & 3) == 0) touchSpriteLines(old);
+    touchSpriteLines(read8(0xFE00 + i*4));
+}
+
+int lcdFrameDirty(void)
+{
+    return frameDirty;
+}
+
+int lcdDirtyRects(struct lcdRect *rects, int max)
+{
+    int n = 0;
+    
+    if (!frameDirty || max < 1) return 0;
+    
+    // 连续的变化行合成一个矩形，超出max后都并进最后一个
+    for (int line = 0; line < 144; line++) {
+        struct lcdRect *r = n ? &rects[n - 1] : NULL;
+        
+        if (!spanX1[line]) continue;
+        if (r && (r->y1 == line || n == max)) {
+            if (spanX0[line] < r->x0) r->x0 = spanX0[line];
+            if (spanX1[line] > r->x1) r->x1 = spanX1[line];
+            r->y1 = line + 1;
+            continue;
+        }
+        r = &rects[n++];
+        r->x0 = spanX0[line];
+        r->x1 = spanX1[line];
+        r->y0 = line;
+        r->y1 = line + 1;
+    }
+    return n;
+}
+
+void lcdSetFrameSkip(int n)
+{
+    atomic_store_explicit(&frameSkip, n, memory_order_relaxed);
+}
+
+void lcdRequestFrame(void)
+{
+    atomic_store_explicit(&frameRequest, 1, memory_order_relaxed);
+}
+
+int lcdFrameSkipped(void)
+{
+    return frameSkipped;
+}
+
+void lcdSkipFrame(int skip)
+{
+    frameSkipped = skip;
+}
+
+void lcdGetState(struct lcdState *state)
+{
+    state->bgp = bgpReg;
+    state->obp0 = obp0Reg;
+    state->obp1 = obp1Reg;
+    state->prevLine = prevLine;
+    state->serial = 0;
+}
+
+void lcdSaveState(struct lcdState *state)
+{
+    lcdGetState(state);
+    state->serial = ++saveSerial;
+    memset(lineTouched, 0, sizeof(lineTouched));
+    vramTouched = 0;
+}
+
+void lcdLoadState(const struct lcdState *state)
+{
+    setBGPalette(state->bgp);
+    setSpritePalette1(state->obp0);
+    setSpritePalette2(state->obp1);
+    prevLine = state->prevLine;
+    // 内存换回去没有经过lcdTouch*：读回最近一次的存档时，存档之后改过的行重新渲染，
+    // 其他存档（或改过显存）所有行都重新渲染；变化区间仍按像素比较
+    if (state->serial == saveSerial && !vramTouched) {
+        for (int line = 0; line < 144; line++) {
+            if (lineTouched[line]) lineClean[line] = 0;
+        }
+    } else {
+        memset(lineClean, 0, sizeof(lineClean));
+    }
+}
+
+// VBlank时决定下一帧是否渲染
+static void nextFrame(void)
+{
+    int skip = atomic_load_explicit(&frameSkip, memory_order_relaxed);
+    
+    LCD.frame++;
+    
+    if (skip == LCD_SKIP_ON_DEMAND) {
+        frameSkipped = !atomic_exchange_explicit(&frameRequest, 0, memory_order_relaxed);
+    } else {
+        frameSkipped = skip > 0 && LCD.frame % (skip + 1) != 0;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////
+
 void sortSprites(struct sprite* sprite, int c)
 {
     // blessed insertion sort
@@ -138,10 +339,15 @@ void sortSprites(struct sprite* sprite, int c)
     }
 }
 
-void drawBgWindow(unsigned int *buf, int line)
+unsigned char* getPixels(void)
+{
+    return pixels;
+}
+
+void drawBgWindow(unsigned char *buf, int line)
 {
     unsigned int mapSelect, tileMapOffset, tileNum, tileAddr, currX, currY;
-    unsigned char buf1, buf2, mask, colour;
+    unsigned char buf1, buf2, mask, colour, layer;
     
     for(int x = 0; x < 160; x++) // for the x size of the window (160x144)
     {
@@ -150,16 +356,18 @@ void drawBgWindow(unsigned int *buf, int line)
             currX = x;
             currY = line - LCD.windowY;
             mapSelect = LCDC.windowTileMap;
+            layer = PIX_WINDOW;
             
         } else {
             // background
             if (!LCDC.bgWindowDisplay) {
-                buf[line*160 + x] = 0; // if not window or background, make it white
+                memset(&buf[line*160 + x], 0, 160 - x); // if not window or background, make it white
                 return;
             }
             currX = (x + LCD.scrollX) % 256; // mod 256 since if it goes off the screen, it wraps around
             currY = (line + LCD.scrollY) % 256;
             mapSelect = LCDC.tileMapSelect;
+            layer = 0;
         }
         
         // map window to 32 rows of 32 bytes
@@ -176,14 +384,14 @@ void drawBgWindow(unsigned int *buf, int line)
         buf2 = read8(tileAddr + (currY%8)*2 + 1);
         mask = 128>>(currX%8);
         colour = (!!(buf2&mask)<<1) | !!(buf1&mask);
-        buf[line*160 + x] = colours[bgPalette[colour]];
+        buf[line*160 + x] = layer | (colour << 2) | bgPalette[colour];
     }
 }
 
-void drawSprites(unsigned int *buf, int line, int blocks, struct sprite *sprite)
+void drawSprites(unsigned char *buf, int line, int blocks, struct sprite *sprite)
 {
     unsigned int buf1, buf2, tileAddr, spriteRow, x;
-    unsigned char mask, colour; int *pal;
+    unsigned char mask, colour, temp; int *pal;
     
     for(int i = 0; i < blocks; i++)
     {
@@ -213,23 +421,37 @@ void drawSprites(unsigned int *buf, int line, int blocks, struct sprite *sprite)
             pal = (sprite[i].flags & 0x10) ? spritePalette2 : spritePalette1;
             
             // only render over colour 0
-            if(sprite[i].flags & 0x80) {
-                unsigned int temp = buf[line*160+(x + sprite[i].x)];
-                if(temp != colours[bgPalette[0]]) continue;
-            }
-            buf[line*160+(x + sprite[i].x)] = colours[pal[colour]]; // for testing
+            temp = buf[line*160+(x + sprite[i].x)];
+            if((sprite[i].flags & 0x80) && PIX_COLOUR(temp) != 0) continue;
+            buf[line*160+(x + sprite[i].x)] = (temp & ~0x03) | PIX_SPRITE | pal[colour];
         }
     }
 }
 
-unsigned int* getPixels(void);
-
 void renderLine(int line)
 {
     int c = 0; // block counter
     struct sprite sprite[10]; // max 10 sprites per line
-    unsigned int *buf = getPixels();//获取像素数组RGBA
+    unsigned char *buf = pixels;//索引像素数组
+    unsigned char old[160];
     int y = 0;
+    int x0, x1;
+    struct lineState st;
+    
+    st.lcdc = getLCDC();
+    st.scx = LCD.scrollX;
+    st.scy = LCD.scrollY;
+    st.wx = LCD.windowX;
+    st.wy = LCD.windowY;
+    st.bgp = bgpReg;
+    st.obp0 = obp0Reg;
+    st.obp1 = obp1Reg;
+    
+    // 输入没有变化，保留上一帧的像素
+    if (lineClean[line] && !memcmp(&lineStates[line], &st, sizeof(st))) return;
+    lineStates[line] = st;
+    lineClean[line] = 1;
+    memcpy(old, &buf[line*160], 160);
     
     // OAM is divided into 40 4-byte blocks each - corresponding to a sprite
     for (int i = 0; i < 40; i++)
@@ -249,21 +471,32 @@ void renderLine(int line)
     
     drawBgWindow(buf, line);
     drawSprites(buf, line, c, sprite);
+    
+    // 和上一帧的像素比较，得到真正变化的区间
+    if (lineForce[line]) {
+        x0 = 0;
+        x1 = 160;
+        lineForce[line] = 0;
+    } else {
+        for (x0 = 0; x0 < 160 && buf[line*160 + x0] == old[x0]; x0++);
+        if (x0 == 160) return;
+        for (x1 = 160; buf[line*160 + x1 - 1] == old[x1 - 1]; x1--);
+    }
+    
+    if (!spanX1[line] || x0 < spanX0[line]) spanX0[line] = x0;
+    if (x1 > spanX1[line]) spanX1[line] = x1;
+    frameDirty = 1;
+    videoLine(&buf[line*160], line);
 }
 
 ///////////////////////////////////////////////////////////////////////
 
-void wnd_draw(uint8_t* pixels);
-int wnd_updateEvent(void);
-
-// lcd循环
+// lcd循环，进入VBlank时返回1
 int lcdCycle()
 {
     int cycles = getCycles();
-    static int prevLine;
-    
     int this_frame;
-    int end = 0;
+    int vblank = 0;
     
     this_frame = cycles % (70224/4); // 70224 clks per screen
     LCD.line = this_frame / (456/4); // 465 clks per line
@@ -279,8 +512,11 @@ int lcdCycle()
     if (LCD.line >= 144)
     LCDS.modeFlag = 1;  // VBlank
     
-    if (LCD.line != prevLine && LCD.line < 144) {
+    if (LCD.line != prevLine && LCD.line < 144 && !frameSkipped) {
+        TIME_BEGIN(t);
         renderLine(LCD.line);
+        TIME_END(t, lineSeconds);
+        COUNT(lines);
     }
     
     if (LCDS.lyInterrupt && LCD.line == LCD.lyCompare) {
@@ -290,15 +526,27 @@ int lcdCycle()
     if (prevLine == 143 && LCD.line == 144) {
         // draw the entire frame
         interrupt.flags |= VBLANK;
-        wnd_draw(NULL);
-        if(wnd_updateEvent()) end = 1;
+        vblank = 1;
     }
     
-    if (end) return 0;
-    
     prevLine = LCD.line;
     
-    return 1;
+    return vblank;
+}
+
+unsigned int lcdNextLine(void)
+{
+    unsigned int cycles = getCycles();
+
+    if (cycles > 0xFFFFFFFF - 70224/4) return cycles;//快要回绕，cycles % 帧长不连续
+    return cycles + (456/4) - cycles % (70224/4) % (456/4);
+}
+
+void lcdFrameEnd(void)
+{
+    frameDirty = 0;
+    memset(spanX1, 0, sizeof(spanX1));
+    nextFrame();
 }
 
 
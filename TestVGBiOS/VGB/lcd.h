@@ -9,6 +9,14 @@
 #ifndef lcd_h
 #define lcd_h
 
+// 索引像素: bit0-1 色阶(调色板之后), bit2-3 背景/窗口原始颜色号(精灵优先级用), bit4 窗口, bit5 精灵
+#define PIX_SHADE(p)    ((p) & 0x03)
+#define PIX_COLOUR(p)   (((p) >> 2) & 0x03)
+#define PIX_WINDOW      0x10
+#define PIX_SPRITE      0x20
+
+#define LCD_SKIP_ON_DEMAND  (-1)
+
 struct LCD {
     int windowX;
     int windowY;
@@ -48,6 +56,25 @@ struct sprite {
     int flags;
 };
 
+// 本帧变化的区域[x0,x1) x [y0,y1)
+struct lcdRect {
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+};
+
+#define LCD_MAX_RECTS   8
+
+// 存档用：lcd.c内部的状态（调色板寄存器原值、上次的扫描行）
+struct lcdState {
+    unsigned char bgp;
+    unsigned char obp0;
+    unsigned char obp1;
+    int prevLine;
+    unsigned int serial;    // 第几次存档，读档时用来判断哪些行还能沿用，不是机器状态
+};
+
 void setLCDC(unsigned char value);
 void setLCDS(unsigned char value);
 void setBGPalette(unsigned char value);
@@ -67,6 +94,28 @@ unsigned char getWindowX(void);
 unsigned char getWindowY(void);
 int getLine(void);
 
+unsigned char* getPixels(void);
+
+void lcdInvalidate(void);
+void lcdTouchVram(unsigned short address);
+void lcdTouchOam(unsigned short address, unsigned char old);
+int lcdFrameDirty(void);
+int lcdDirtyRects(struct lcdRect *rects, int max);//在wnd_draw里调用，返回矩形个数
+
+// 每n+1帧渲染1帧（跳过n帧，n=0不跳帧），或LCD_SKIP_ON_DEMAND时只在lcdRequestFrame之后渲染下一帧
+// 这两个可以在任意线程调用，下一次VBlank时生效
+void lcdSetFrameSkip(int n);
+void lcdRequestFrame(void);
+// 当前帧是否渲染（run-ahead时真实帧不渲染）
+int lcdFrameSkipped(void);
+void lcdSkipFrame(int skip);
+
+void lcdSaveState(struct lcdState *state);
+void lcdGetState(struct lcdState *state);   // 只取值，不算一次存档（算哈希用）
+void lcdLoadState(const struct lcdState *state);
+
 int lcdCycle(void);
+unsigned int lcdNextLine(void);    // LY下一次变化时的周期
+void lcdFrameEnd(void);//帧呈现之后调用：清掉变化记录，决定下一帧是否渲染
 
 #endif /* lcd_h */
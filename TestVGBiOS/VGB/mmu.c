@@ -29,9 +29,11 @@ jump vectors：
 
 #include "mmu.h"
 
+#include "counters.h"
 #include "lcd.h"
 #include "rom.h"
 #include "interrupt.h"
+#include "input.h"
 #include "timer.h"
 
 unsigned char cart[0x8000];   // ROM (Cart 1 & 2)
@@ -42,7 +44,7 @@ unsigned char oam[0x100];     // Sprite Attribute Memory
 unsigned char io[0x100];     // Input/Output - Not sure if I need 0x100, 0x40 may suffice
 unsigned char hram[0x80];    // High RAM
 
-char jb = 0, jd = 0;
+unsigned char pageDirty[MEM_PAGES];
 
 void memInit(void)
 {
@@ -52,6 +54,7 @@ void memInit(void)
     memset(oam, 0, sizeof(oam));
     memset(wram, 0, sizeof(wram));
     memset(hram, 0, sizeof(hram));
+    memTouchAll();
     //
     write8(0xFF10, 0x80);
     write8(0xFF11, 0xBF);
@@ -74,11 +77,26 @@ void memInit(void)
     write8(0xFF49, 0xFF);
 }
 
-unsigned int getButton(void);
-unsigned int getDirection(void);
+unsigned char *memPage(int page, int *size)
+{
+    *size = MEM_PAGE;
+    if (page < PAGE_SRAM) return vram + (page - PAGE_VRAM) * MEM_PAGE;
+    if (page < PAGE_WRAM) return sram + (page - PAGE_SRAM) * MEM_PAGE;
+    if (page < PAGE_OAM) return wram + (page - PAGE_WRAM) * MEM_PAGE;
+    if (page == PAGE_OAM) return oam;
+    if (page == PAGE_IO) return io;
+    *size = sizeof(hram);
+    return hram;
+}
+
+void memTouchAll(void)
+{
+    memset(pageDirty, 0xFF, sizeof(pageDirty));
+}
 
 unsigned char read8(unsigned short address)
 {
+    COUNT_READ(address);
     if (0x0000 <= address && address <= 0x7FFF)
         return cart[address];
     else if (0x8000 <= address && address <= 0x9FFF)
@@ -91,12 +109,8 @@ unsigned char read8(unsigned short address)
         return wram[address - 0xE000];
     else if (0xFE00 <= address && address <= 0xFEFF)
         return oam[address - 0xFE00];
-    else if (address == 0xFF00) {
-        unsigned char mask = 0;
-        if (!jb) mask = getButton();
-        if (!jd) mask = getDirection();
-        return (0xC0 | (0xF ^ mask) | ((jb) | (jd)));
-    }
+    else if (address == 0xFF00)
+        return inputRead();
     else if (address == 0xFF04)
         return getDiv();
     else if (address == 0xFF05)
@@ -127,6 +141,25 @@ unsigned char read8(unsigned short address)
     return 0;
 }
 
+unsigned char peek8(unsigned short address)
+{
+    if (address <= 0x7FFF)
+        return cart[address];
+    else if (address <= 0x9FFF)
+        return vram[address - 0x8000];
+    else if (address <= 0xBFFF)
+        return sram[address - 0xA000];
+    else if (address <= 0xFDFF) // 含wram的镜像
+        return wram[(address - 0xC000) & 0x1FFF];
+    else if (address <= 0xFEFF)
+        return oam[address - 0xFE00];
+    else if (address <= 0xFF7F)
+        return io[address - 0xFF00];
+    else if (address <= 0xFFFE)
+        return hram[address - 0xFF80];
+    return interrupt.enable;
+}
+
 unsigned short read16(unsigned short address)
 {
     return (read8(address) | (read8(address+1) << 8));
@@ -134,17 +167,35 @@ unsigned short read16(unsigned short address)
 
 void write8(unsigned short address, unsigned char value)
 {
+    COUNT_WRITE(address);
     // can't write to ROM
-    if (0x8000 <= address && address <= 0x9FFF)
-        vram[address - 0x8000] = value;
-    else if (0xA000 <= address && address <= 0xBFFF)
+    if (0x8000 <= address && address <= 0x9FFF) {
+        if (vram[address - 0x8000] != value) {
+            vram[address - 0x8000] = value;
+            pageDirty[PAGE_VRAM + ((address - 0x8000) >> 8)] = 0xFF;
+            lcdTouchVram(address);
+        }
+    }
+    else if (0xA000 <= address && address <= 0xBFFF) {
         sram[address - 0xA000] = value;
-    else if (0xC000 <= address && address <= 0xDFFF)
+        pageDirty[PAGE_SRAM + ((address - 0xA000) >> 8)] = 0xFF;
+    }
+    else if (0xC000 <= address && address <= 0xDFFF) {
         wram[address - 0xC000] = value;
-    else if (0xE000 <= address && address <= 0xFDFF)
+        pageDirty[PAGE_WRAM + ((address - 0xC000) >> 8)] = 0xFF;
+    }
+    else if (0xE000 <= address && address <= 0xFDFF) {
         wram[address - 0xE000] = value;
-    else if (0xFE00 <= address && address <= 0xFEFF)
-        oam[address - 0xFE00] = value;
+        pageDirty[PAGE_WRAM + ((address - 0xE000) >> 8)] = 0xFF;
+    }
+    else if (0xFE00 <= address && address <= 0xFEFF) {
+        unsigned char old = oam[address - 0xFE00];
+        if (old != value) {
+            oam[address - 0xFE00] = value;
+            pageDirty[PAGE_OAM] = 0xFF;
+            lcdTouchOam(address, old);
+        }
+    }
     else if (address == 0xFF04)
         setDiv(value);
     else if (address == 0xFF05)
@@ -176,13 +227,16 @@ void write8(unsigned short address, unsigned char value)
         setWindowY(value);
     else if (address == 0xFF4B)
         setWindowX(value);
-    else if (address == 0xFF00) {
-        jb = value & 0x20; jd = value & 0x10; 
-    }
-    else if(0xFF00 <= address && address <= 0xFF7F)
+    else if (address == 0xFF00)
+        inputWrite(value);
+    else if(0xFF00 <= address && address <= 0xFF7F) {
         io[address - 0xFF00] = value;
-    else if (0xFF80 <= address && address <= 0xFFFE)
+        pageDirty[PAGE_IO] = 0xFF;
+    }
+    else if (0xFF80 <= address && address <= 0xFFFE) {
         hram[address - 0xFF80] = value;
+        pageDirty[PAGE_HRAM] = 0xFF;
+    }
     else if (address == 0xFF0F)
         interrupt.flags = value;
     else if (address == 0xFFFF)
@@ -12,10 +12,36 @@
 #include <stdio.h>
 
 extern unsigned char cart[];   // ROM (Cart 1 & 2)
+extern unsigned char vram[0x2000];
+extern unsigned char sram[0x2000];
+extern unsigned char wram[0x2000];
+extern unsigned char oam[0x100];
+extern unsigned char io[0x100];
+extern unsigned char hram[0x80];
+
+// 内存数组按256字节分页，write8写一页时把pageDirty[页]的所有位置1，
+// 各使用者（cow.c、digest.c）只清自己那一位
+#define MEM_PAGE    256
+#define PAGE_VRAM   0       // 32页
+#define PAGE_SRAM   32      // 32页
+#define PAGE_WRAM   64      // 32页
+#define PAGE_OAM    96
+#define PAGE_IO     97
+#define PAGE_HRAM   98      // 只有128字节
+#define MEM_PAGES   99
+
+#define DIRTY_COW   0x01
+#define DIRTY_HASH  0x02
+
+extern unsigned char pageDirty[MEM_PAGES];
 
 void memInit(void);
+unsigned char *memPage(int page, int *size);
+void memTouchAll(void);     // 内存被整块换掉时（读档）
 unsigned char read8(unsigned short address);
 unsigned short read16(unsigned short address);
+// 不计数、没有副作用的读（性能分析、轨迹取指令字节），I/O寄存器直接取io[]
+unsigned char peek8(unsigned short address);
 void write8(unsigned short address, unsigned char value);
 void write16(unsigned short address, unsigned short value);
 
@@ -0,0 +1,347 @@
+//
+//  movie.c
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+/*
+ 输入录像：初始存档 + 每个按键事件生效的帧号和帧内周期 + 每帧画面的哈希。
+
+ 录的是事件在模拟里真正生效的周期，不是宿主的时间戳，所以回放时把事件直接
+ 排到同一个周期上，和宿主的快慢无关，逐位重现。上一帧没来得及生效、在下一
+ 帧开始时才生效的事件记成MOVIE_LATE，回放时同样留到帧开始生效。
+
+ 回放时宿主的按键全部丢掉；每帧结束时比较画面哈希和机器状态的哈希，记下第一次
+ 不一致的帧。没有渲染的帧（跳帧、run-ahead的真实帧）画面哈希为0，只比较机器状态。
+ */
+
+#include "movie.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu.h"
+#include "digest.h"
+#include "hash.h"
+#include "lcd.h"
+#include "mmu.h"
+#include "state.h"
+
+#define MOVIE_LATE  0xFFFF  // 帧内周期：帧开始时才生效
+
+#define IDLE        0
+#define RECORDING   1
+#define PLAYING     2
+
+struct movieEvent {
+    unsigned int frame;
+    unsigned short cycle;
+    unsigned char button;
+    unsigned char down;
+};
+
+struct movieHash {
+    uint64_t frame;     // 0为没有渲染
+    uint64_t state;     // 0为没有（版本1的录像）
+};
+
+static int mode;
+static unsigned long frame;     // 当前帧
+static unsigned int frameStart; // 当前帧开始时的周期
+
+static struct movieEvent *events;
+static unsigned long eventN, eventCap, next;
+static struct movieHash *hashes;
+static unsigned long hashN, hashCap;
+static unsigned long length;
+static unsigned char *initial;  // 初始存档
+static long initialN;
+
+static struct movieStats stats;
+
+static void put16(unsigned char *p, unsigned int v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static void put32(unsigned char *p, unsigned int v)
+{
+    put16(p, v);
+    put16(p + 2, v >> 16);
+}
+
+static void put64(unsigned char *p, uint64_t v)
+{
+    put32(p, (unsigned int)v);
+    put32(p + 4, (unsigned int)(v >> 32));
+}
+
+static unsigned int get16(const unsigned char *p)
+{
+    return p[0] | p[1] << 8;
+}
+
+static unsigned int get32(const unsigned char *p)
+{
+    return get16(p) | get16(p + 2) << 16;
+}
+
+static uint64_t get64(const unsigned char *p)
+{
+    return get32(p) | (uint64_t)get32(p + 4) << 32;
+}
+
+static uint64_t romHash(void)
+{
+    return hash64(cart, 0x8000, 0);
+}
+
+static uint64_t frameHash(void)
+{
+    return lcdFrameSkipped() ? 0 : hash64(getPixels(), 160 * 144, 0);
+}
+
+static void reset(void)
+{
+    free(events);
+    free(hashes);
+    events = NULL;
+    hashes = NULL;
+    eventN = eventCap = next = 0;
+    hashN = hashCap = 0;
+    length = 0;
+    memset(&stats, 0, sizeof(stats));
+    stats.firstMismatch = -1;
+    frame = 0;
+    frameStart = getCycles();
+}
+
+int movieRecord(void)
+{
+    reset();
+    free(initial);
+    initialN = stateSize();
+    initial = malloc(initialN);
+    if (!initial) return MOVIE_ERR_MEMORY;
+    stateWrite(initial, initialN);
+    mode = RECORDING;
+    return 0;
+}
+
+void movieStop(void)
+{
+    mode = IDLE;
+}
+
+int movieRecording(void)
+{
+    return mode == RECORDING;
+}
+
+int moviePlaying(void)
+{
+    return mode == PLAYING;
+}
+
+unsigned long movieLength(void)
+{
+    return length;
+}
+
+int movieSave(const char *path)
+{
+    unsigned char head[MOVIE_HEADER], rec[8];
+    unsigned long n = 0;
+    FILE *f;
+    int err = 0;
+
+    if (mode == RECORDING) mode = IDLE;
+    if (!initial) return MOVIE_ERR_FORMAT;
+    while (n < eventN && events[n].frame < hashN) n++;  // 没录完的一帧不要
+
+    memset(head, 0, sizeof(head));
+    memcpy(head, MOVIE_MAGIC, 4);
+    put16(head + 4, MOVIE_VERSION);
+    put64(head + 8, romHash());
+    put32(head + 16, (unsigned int)hashN);
+    put32(head + 20, (unsigned int)n);
+    put32(head + 24, (unsigned int)initialN);
+
+    f = fopen(path, "wb");
+    if (!f) return MOVIE_ERR_IO;
+    if (fwrite(head, 1, sizeof(head), f) != sizeof(head)) err = MOVIE_ERR_IO;
+    if (fwrite(initial, 1, initialN, f) != (size_t)initialN) err = MOVIE_ERR_IO;
+    for (unsigned long i = 0; i < n && !err; i++) {
+        put32(rec, events[i].frame);
+        put16(rec + 4, events[i].cycle);
+        rec[6] = events[i].button;
+        rec[7] = events[i].down;
+        if (fwrite(rec, 1, 8, f) != 8) err = MOVIE_ERR_IO;
+    }
+    for (unsigned long i = 0; i < hashN && !err; i++) {
+        unsigned char h[16];
+        put64(h, hashes[i].frame);
+        put64(h + 8, hashes[i].state);
+        if (fwrite(h, 1, 16, f) != 16) err = MOVIE_ERR_IO;
+    }
+    if (fclose(f) != 0) err = MOVIE_ERR_IO;
+    return err;
+}
+
+int moviePlay(const char *path)
+{
+    unsigned char head[MOVIE_HEADER], *buf = NULL;
+    unsigned long frames, n;
+    long size, need;
+    FILE *f;
+    int err, version, hashSize;
+
+    mode = IDLE;
+    f = fopen(path, "rb");
+    if (!f) return MOVIE_ERR_IO;
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    rewind(f);
+    if (size < MOVIE_HEADER || fread(head, 1, MOVIE_HEADER, f) != MOVIE_HEADER) {
+        fclose(f);
+        return MOVIE_ERR_FORMAT;
+    }
+    frames = get32(head + 16);
+    n = get32(head + 20);
+    initialN = get32(head + 24);
+    version = get16(head + 4);
+    hashSize = version >= 2 ? 16 : 8;
+    need = MOVIE_HEADER + initialN + (long)n * 8 + (long)frames * hashSize;
+    if (memcmp(head, MOVIE_MAGIC, 4) || version > MOVIE_VERSION || size < need) {
+        fclose(f);
+        return MOVIE_ERR_FORMAT;
+    }
+    if (get64(head + 8) != romHash()) {
+        fclose(f);
+        return MOVIE_ERR_ROM;
+    }
+
+    reset();
+    free(initial);
+    initial = malloc(initialN);
+    buf = malloc(n * 8 + frames * hashSize + 1);
+    events = malloc(n * sizeof(*events) + 1);
+    hashes = malloc(frames * sizeof(*hashes) + 1);
+    if (!initial || !buf || !events || !hashes) {
+        fclose(f);
+        free(buf);
+        return MOVIE_ERR_MEMORY;
+    }
+    if (fread(initial, 1, initialN, f) != (size_t)initialN || fread(buf, 1, n * 8 + frames * hashSize, f) != n * 8 + frames * hashSize) {
+        fclose(f);
+        free(buf);
+        return MOVIE_ERR_IO;
+    }
+    fclose(f);
+
+    for (unsigned long i = 0; i < n; i++) {
+        const unsigned char *p = buf + i * 8;
+        events[i].frame = get32(p);
+        events[i].cycle = get16(p + 4);
+        events[i].button = p[6] & 7;
+        events[i].down = p[7] != 0;
+        if (i && events[i].frame < events[i - 1].frame) {
+            free(buf);
+            return MOVIE_ERR_FORMAT;
+        }
+    }
+    for (unsigned long i = 0; i < frames; i++) {
+        const unsigned char *p = buf + n * 8 + i * hashSize;
+        hashes[i].frame = get64(p);
+        hashes[i].state = hashSize == 16 ? get64(p + 8) : 0;
+    }
+    free(buf);
+    eventN = eventCap = n;
+    hashN = hashCap = frames;
+    length = frames;
+
+    err = stateRead(initial, initialN);
+    if (err) return MOVIE_ERR_STATE;
+    frameStart = getCycles();
+    mode = length ? PLAYING : IDLE;
+    return 0;
+}
+
+static int grow(void **p, unsigned long *cap, unsigned long n, size_t size)
+{
+    void *q;
+    unsigned long c;
+
+    if (n < *cap) return 0;
+    c = *cap ? *cap * 2 : 1024;
+    q = realloc(*p, c * size);
+    if (!q) return -1;
+    *p = q;
+    *cap = c;
+    return 0;
+}
+
+void movieFrame(void)
+{
+    struct movieHash h;
+
+    if (mode == IDLE) return;
+    h.frame = frameHash();
+    h.state = digestMachine();
+    if (mode == RECORDING) {
+        if (grow((void **)&hashes, &hashCap, hashN, sizeof(*hashes)) == 0) hashes[hashN++] = h;
+    } else {
+        const struct movieHash *r = &hashes[frame];
+        int frameChecked = h.frame && r->frame;
+        int stateChecked = r->state != 0;
+
+        if (frameChecked || stateChecked) stats.checked++;
+        if ((frameChecked && h.frame != r->frame) || (stateChecked && h.state != r->state)) {
+            if (!stats.mismatches) stats.firstMismatch = frame;
+            stats.mismatches++;
+        }
+    }
+    frame++;
+    frameStart = getCycles();
+    stats.frames = frame;
+    if (mode == PLAYING && frame >= length) mode = IDLE;
+}
+
+void movieInput(int button, int down, int late)
+{
+    struct movieEvent *e;
+    unsigned int c = getCycles() - frameStart;
+
+    if (mode != RECORDING) return;
+    if (grow((void **)&events, &eventCap, eventN, sizeof(*events))) return;
+    e = &events[eventN++];
+    e->frame = (unsigned int)frame;
+    e->cycle = late || c >= MOVIE_LATE ? MOVIE_LATE : c;
+    e->button = button;
+    e->down = down;
+    stats.events++;
+}
+
+int movieEvent(int *button, int *down, unsigned int *cycle)
+{
+    const struct movieEvent *e;
+
+    if (mode != PLAYING) return 0;
+    while (next < eventN && events[next].frame < frame) next++;
+    if (next >= eventN || events[next].frame != frame) return 0;
+    e = &events[next++];
+    *button = e->button;
+    *down = e->down;
+    *cycle = frameStart + e->cycle;
+    stats.events++;
+    return 1;
+}
+
+void movieGetStats(struct movieStats *s)
+{
+    *s = stats;
+}
@@ -0,0 +1,59 @@
+//
+//  movie.h
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+#ifndef movie_h
+#define movie_h
+
+#include <stdint.h>
+
+/*
+ 录像文件格式（小端）：
+   头 32字节: "VGBM" | u16 版本 | u16 0 | u64 ROM哈希 | u32 帧数 | u32 事件数 | u32 初始存档长度 | u32 0
+   初始存档（state.h的格式）
+   事件 8字节 x 事件数: u32 帧号 | u16 帧内周期 | u8 按键 | u8 按下
+   帧哈希 16字节 x 帧数: u64 每帧结束时lcd画面的hash64，没有渲染的帧为0 |
+                         u64 同一时刻的机器状态（digestMachine）
+ 帧号从开始录制算起，帧内周期相对帧开始（inputFrame）时的getCycles()。
+ 版本1的帧哈希只有8字节的画面哈希，回放时不比较机器状态。
+ */
+#define MOVIE_MAGIC     "VGBM"
+#define MOVIE_VERSION   2
+#define MOVIE_HEADER    32
+
+#define MOVIE_ERR_IO        (-1)
+#define MOVIE_ERR_MEMORY    (-2)
+#define MOVIE_ERR_FORMAT    (-3)
+#define MOVIE_ERR_ROM       (-4)    // 不是当前卡带录的
+#define MOVIE_ERR_STATE     (-5)    // 初始存档读不进来
+
+struct movieStats {
+    unsigned long frames;       // 录制/回放了的帧
+    unsigned long events;
+    unsigned long checked;      // 回放时比较过哈希（画面或机器状态）的帧
+    unsigned long mismatches;
+    long firstMismatch;         // 第一次不一致的帧，-1为没有
+};
+
+// 以下只在模拟线程、帧之间调用
+int movieRecord(void);              // 从当前状态开始录
+int movieSave(const char *path);    // 停止录制并写文件
+int moviePlay(const char *path);    // 校验ROM、读初始存档，从下一帧开始回放
+void movieStop(void);
+int movieRecording(void);
+int moviePlaying(void);             // 回放到最后一帧后自动停止
+unsigned long movieLength(void);    // 回放的总帧数
+
+void movieGetStats(struct movieStats *stats);
+
+// input.c的钩子：每帧开始时（取走上一帧的哈希）、按键生效时（late为上一帧剩下的事件）、
+// 回放时取本帧的事件
+void movieFrame(void);
+void movieInput(int button, int down, int late);
+int movieEvent(int *button, int *down, unsigned int *cycle);
+
+#endif /* movie_h */
@@ -0,0 +1,171 @@
+//
+//  pace.c
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+/*
+ 帧节奏控制。
+ 
+ PACE_EXACT以真实DMG的刷新率(4194304/70224 = 59.7275Hz)排下一帧的截止时间，
+ 截止时间逐帧累加而不是每帧从当前时间算起，所以不会累积漂移；如果落后超过
+ PACE_MAX_LAG帧（比如被系统挂起）就放弃追赶，从当前时间重新开始。
+ 
+ PACE_DISPLAY等待宿主在屏幕刷新时调用paceDisplayTick，超时后自行放行，
+ 避免宿主停止回调时模拟线程卡死。
+ 
+ paceSetMode可以在任意线程调用，只记下请求，由模拟线程在下一次paceFrame时切换，
+ 截止时间等状态只有模拟线程读写。
+ */
+
+#include "pace.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#define PACE_MAX_LAG    3
+
+static int mode;
+static atomic_int requested; // paceSetMode要的模式
+static int64_t period;      // ns
+static int64_t deadline;    // 下一帧的截止时间
+static int64_t lastFrame;
+
+static pthread_mutex_t displayLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t displayCond = PTHREAD_COND_INITIALIZER;
+static unsigned long displayTicks, displaySeen;
+
+static struct paceStats stats;
+static double m2; // Welford方差累积
+
+static int64_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void sleepUntil(int64_t t)
+{
+    int64_t t0 = now();
+    int64_t d = t - t0;
+    if (d <= 0) return;
+    
+    struct timespec ts = { (time_t)(d / 1000000000), (long)(d % 1000000000) };
+    nanosleep(&ts, NULL);
+    stats.sleepMs += (now() - t0) / 1e6;//实际睡了多久，包括多睡的
+}
+
+static void waitDisplay(void)
+{
+    int64_t t0 = now();
+    int64_t limit = t0 + period * 2;
+    
+    pthread_mutex_lock(&displayLock);
+    while (displayTicks == displaySeen) {
+        // pthread_cond_timedwait使用CLOCK_REALTIME，把剩余时间换算过去
+        struct timespec ts;
+        int64_t rel = limit - now(), at;
+        if (rel <= 0) break;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        at = (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec + rel;
+        ts.tv_sec = (time_t)(at / 1000000000);
+        ts.tv_nsec = (long)(at % 1000000000);
+        pthread_cond_timedwait(&displayCond, &displayLock, &ts);
+    }
+    displaySeen = displayTicks;
+    pthread_mutex_unlock(&displayLock);
+    
+    stats.sleepMs += (now() - t0) / 1e6;
+}
+
+static void record(int64_t t)
+{
+    if (lastFrame) {
+        double ms = (t - lastFrame) / 1e6;
+        double delta = ms - stats.meanMs;
+        stats.frames++;
+        stats.meanMs += delta / stats.frames;
+        m2 += delta * (ms - stats.meanMs);
+        stats.jitterMs = stats.frames > 1 ? sqrt(m2 / (stats.frames - 1)) : 0;
+        if (ms > stats.maxMs) stats.maxMs = ms;
+    }
+    lastFrame = t;
+}
+
+static void apply(int m)
+{
+    mode = m;
+    deadline = now() + period;
+    lastFrame = 0;
+}
+
+void paceInit(int m)
+{
+    period = (int64_t)(1e9 / PACE_HZ);
+    paceResetStats();
+    atomic_store(&requested, m);
+    apply(m);
+}
+
+void paceSetMode(int m)
+{
+    atomic_store_explicit(&requested, m, memory_order_release);
+}
+
+int paceGetMode(void)
+{
+    return atomic_load_explicit(&requested, memory_order_acquire);
+}
+
+void paceFrame(void)
+{
+    int64_t t;
+    int m = atomic_load_explicit(&requested, memory_order_acquire);
+    
+    if (m != mode) apply(m);
+    switch (mode) {
+        case PACE_EXACT:
+            if (now() > deadline + period * PACE_MAX_LAG) {
+                deadline = now();
+                stats.late++;
+            }
+            sleepUntil(deadline);
+            deadline += period;
+            break;
+        case PACE_DISPLAY:
+            waitDisplay();
+            break;
+        default:
+            break;
+    }
+    
+    t = now();
+    record(t);
+}
+
+void paceDisplayTick(void)
+{
+    pthread_mutex_lock(&displayLock);
+    displayTicks++;
+    pthread_cond_signal(&displayCond);
+    pthread_mutex_unlock(&displayLock);
+}
+
+void paceGetStats(struct paceStats *s)
+{
+    *s = stats;
+}
+
+void paceResetStats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+    m2 = 0;
+    lastFrame = 0;
+}
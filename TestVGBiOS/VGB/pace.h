@@ -0,0 +1,41 @@
+//
+//  pace.h
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+#ifndef pace_h
+#define pace_h
+
+// 帧节奏模式
+#define PACE_UNTHROTTLED    0   // 不限速，用于跑分和快进
+#define PACE_EXACT          1   // 59.7275Hz，带漂移校正
+#define PACE_DISPLAY        2   // 跟随宿主屏幕刷新(paceDisplayTick)
+
+#define PACE_HZ             (4194304.0 / 70224.0)
+
+struct paceStats {
+    unsigned long frames;
+    double meanMs;      // 平均帧间隔
+    double jitterMs;    // 帧间隔标准差
+    double maxMs;       // 最长帧间隔
+    unsigned long late; // 错过截止时间而重新同步的次数
+    double sleepMs;     // 累计等待时间
+};
+
+void paceInit(int mode);
+void paceSetMode(int mode);     // 任意线程，下一次paceFrame时生效
+int paceGetMode(void);
+
+// 每帧结束时由模拟线程调用，按当前模式等待
+void paceFrame(void);
+
+// 屏幕刷新回调（任意线程），PACE_DISPLAY模式下放行一帧
+void paceDisplayTick(void);
+
+void paceGetStats(struct paceStats *stats);
+void paceResetStats(void);
+
+#endif /* pace_h */
@@ -0,0 +1,162 @@
+//
+//  present.c
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+/*
+ 无锁三缓冲：生产者(模拟线程)独占back，消费者(宿主)独占front，中间的middle
+ 用一个原子变量交换，带FRESH标记表示它是还没被取走的新帧。
+
+ 生产者写完back后和middle交换，永远不等；如果换出来的middle还带着FRESH，
+ 说明上一帧没人取就被覆盖了（丢帧）。消费者只在middle带FRESH时才和它交换，
+ 所以总是拿到最新完成的一帧，而且一直持有到下一次换帧。
+
+ 每块缓冲里是几帧之前的画面，生产者开始写时要把它错过的那几帧的变化区域
+ 一起补画；落后太多或者被作废的缓冲整帧重画。这些记录只有生产者访问。
+ */
+
+#include "present.h"
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "latency.h"
+
+#define FRESH   4
+
+static unsigned char *buffers[PRESENT_BUFFERS];
+static void *owned;         // 自己分配的内存
+
+static atomic_int middle;   // 缓冲号 | FRESH
+static int back;            // 生产者独占
+static int front;           // 消费者独占
+static struct presentFrame frames[PRESENT_BUFFERS];  // 完成时的尺寸和格式，随交换发布
+
+static atomic_ulong fence;  // 最新完成的帧
+static atomic_ulong published, consumed, dropped, duplicated;
+
+// 以下只有生产者访问
+static unsigned long content[PRESENT_BUFFERS];  // 缓冲里是哪一帧，0为空
+static unsigned long validFrom; // 早于这一帧的内容作废
+static int width, height;
+static struct lcdRect history[PRESENT_BUFFERS][LCD_MAX_RECTS];  // 最近几帧的变化区域，按帧序号取模
+static int historyN[PRESENT_BUFFERS];
+
+int presentInit(int size, void *memory)
+{
+    free(owned);
+    owned = NULL;
+    if (!memory) {
+        memory = owned = calloc(PRESENT_BUFFERS, size);
+        if (!memory) return -1;
+    }
+    for (int i = 0; i < PRESENT_BUFFERS; i++) {
+        buffers[i] = (unsigned char *)memory + (long)i * size;
+        content[i] = 0;
+    }
+    back = 0;
+    atomic_store(&middle, 1);
+    front = 2;
+    validFrom = atomic_load(&fence) + 1;
+    presentResetStats();
+    return 0;
+}
+
+void presentShutdown(void)
+{
+    free(owned);
+    owned = NULL;
+}
+
+void presentInvalidate(int w, int h)
+{
+    width = w;
+    height = h;
+    validFrom = atomic_load_explicit(&fence, memory_order_relaxed) + 1;
+}
+
+int presentBegin(const struct lcdRect *rects, int n, struct presentFrame *frame, struct lcdRect *damage)
+{
+    unsigned long f = atomic_load_explicit(&fence, memory_order_relaxed) + 1;
+    unsigned long c = content[back];
+    int nd = 0;
+
+    if (n > LCD_MAX_RECTS) n = LCD_MAX_RECTS;
+    memcpy(history[f % PRESENT_BUFFERS], rects, n * sizeof(*rects));
+    historyN[f % PRESENT_BUFFERS] = n;
+
+    if (!c || c < validFrom || f - c > PRESENT_BUFFERS) {
+        damage[0].x0 = 0;
+        damage[0].y0 = 0;
+        damage[0].x1 = width;
+        damage[0].y1 = height;
+        nd = 1;
+    } else {
+        for (unsigned long k = c + 1; k <= f; k++) {
+            memcpy(&damage[nd], history[k % PRESENT_BUFFERS], historyN[k % PRESENT_BUFFERS] * sizeof(*damage));
+            nd += historyN[k % PRESENT_BUFFERS];
+        }
+    }
+    content[back] = 0;
+
+    frame->pixels = buffers[back];
+    frame->index = back;
+    frame->fence = f;
+    return nd;
+}
+
+void presentEnd(const struct presentFrame *frame)
+{
+    int prev;
+
+    content[back] = frame->fence;
+    frames[back] = *frame;
+    prev = atomic_exchange_explicit(&middle, back | FRESH, memory_order_acq_rel);
+    if (prev & FRESH) atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+    back = prev & ~FRESH;
+
+    atomic_store_explicit(&fence, frame->fence, memory_order_release);
+    atomic_fetch_add_explicit(&published, 1, memory_order_relaxed);
+}
+
+int presentAcquire(struct presentFrame *frame)
+{
+    int prev;
+
+    if (!(atomic_load_explicit(&middle, memory_order_relaxed) & FRESH)) {
+        atomic_fetch_add_explicit(&duplicated, 1, memory_order_relaxed);
+        return 0;
+    }
+    // 生产者只会把FRESH放进middle，不会清掉，所以这里换到的一定是新帧
+    prev = atomic_exchange_explicit(&middle, front, memory_order_acq_rel);
+    front = prev & ~FRESH;
+    *frame = frames[front];
+    atomic_fetch_add_explicit(&consumed, 1, memory_order_relaxed);
+    latencyAcquired(frame->fence);
+    return 1;
+}
+
+unsigned long presentFence(void)
+{
+    return atomic_load_explicit(&fence, memory_order_acquire);
+}
+
+void presentGetStats(struct presentStats *stats)
+{
+    stats->published = atomic_load_explicit(&published, memory_order_relaxed);
+    stats->consumed = atomic_load_explicit(&consumed, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&dropped, memory_order_relaxed);
+    stats->duplicated = atomic_load_explicit(&duplicated, memory_order_relaxed);
+}
+
+void presentResetStats(void)
+{
+    atomic_store(&published, 0);
+    atomic_store(&consumed, 0);
+    atomic_store(&dropped, 0);
+    atomic_store(&duplicated, 0);
+}
@@ -0,0 +1,56 @@
+//
+//  present.h
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+#ifndef present_h
+#define present_h
+
+#include "lcd.h"
+
+#define PRESENT_BUFFERS     3
+#define PRESENT_MAX_DAMAGE  (PRESENT_BUFFERS * LCD_MAX_RECTS)
+
+// 常驻的呈现缓冲，地址在presentInit之后不再变化
+struct presentFrame {
+    unsigned char *pixels;
+    int index;
+    unsigned long fence;    // 帧序号，从1开始递增
+    int width;              // 以下由生产者在presentEnd之前填好
+    int height;
+    int stride;
+    int format;
+};
+
+struct presentStats {
+    unsigned long published;    // 生产者完成的帧
+    unsigned long consumed;     // 宿主取走的帧
+    unsigned long dropped;      // 没被取走就被更新的帧覆盖
+    unsigned long duplicated;   // 宿主来取时没有新帧（重复显示上一帧）
+};
+
+// memory为NULL时自己分配，否则使用调用者提供的PRESENT_BUFFERS*size字节（如共享内存）
+// 在模拟线程和宿主开始取帧之前调用
+int presentInit(int size, void *memory);
+void presentShutdown(void);
+
+// 以下三个只在生产者（模拟线程）调用，从不阻塞
+// 之后所有缓冲都按整帧重画（尺寸或格式变化时）
+void presentInvalidate(int width, int height);
+// 取生产者独占的缓冲，damage返回这块缓冲需要重画的区域
+// （本帧变化rects加上它错过的帧的变化），返回区域个数
+int presentBegin(const struct lcdRect *rects, int n, struct presentFrame *frame, struct lcdRect *damage);
+void presentEnd(const struct presentFrame *frame);
+
+// 消费者（宿主）：换到最新完成的一帧，一直持有到下一次换帧；没有新帧时返回0，继续用手上的帧
+int presentAcquire(struct presentFrame *frame);
+
+// 任意线程
+unsigned long presentFence(void);// 最新完成的帧
+void presentGetStats(struct presentStats *stats);
+void presentResetStats(void);
+
+#endif /* present_h */
@@ -0,0 +1,370 @@
+//
+//  profile.c
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+/*
+ 每条指令的周期记到它的地址上，同时记到当前调用栈的节点上。
+
+ 调用栈靠CALL/RST/中断压一帧、RET/RETI弹一帧，每帧记着压入返回地址之后的SP。
+ 游戏常常自己改栈（PUSH+RET跳转、POP掉返回地址不回来），所以RET时按SP对：
+ 帧的SP比RET时的SP低的是已经被丢掉的帧，一起弹掉；比它高的说明这个RET弹的
+ 不是CALL压的地址，不动调用栈。
+
+ 调用树的节点是（父节点，函数入口地址），子节点挂成链表。节点用完后新的调用
+ 记在调用者上。没有MBC，ROM的bank由地址决定（0000-3FFF为00，4000-7FFF为01），
+ 所以按地址分桶就是按bank和地址分桶。
+
+ 另外按操作码（CB前缀的另算256个）记次数和周期，以及相邻两条指令的组合，
+ 用来挑值得单独优化或合并的指令。
+ */
+
+#include "profile.h"
+
+#include <string.h>
+
+static const char *const low[64] = {
+    "NOP", "LD BC,nn", "LD (BC),A", "INC BC", "INC B", "DEC B", "LD B,n", "RLCA",
+    "LD (nn),SP", "ADD HL,BC", "LD A,(BC)", "DEC BC", "INC C", "DEC C", "LD C,n", "RRCA",
+    "STOP", "LD DE,nn", "LD (DE),A", "INC DE", "INC D", "DEC D", "LD D,n", "RLA",
+    "JR e", "ADD HL,DE", "LD A,(DE)", "DEC DE", "INC E", "DEC E", "LD E,n", "RRA",
+    "JR NZ,e", "LD HL,nn", "LD (HL+),A", "INC HL", "INC H", "DEC H", "LD H,n", "DAA",
+    "JR Z,e", "ADD HL,HL", "LD A,(HL+)", "DEC HL", "INC L", "DEC L", "LD L,n", "CPL",
+    "JR NC,e", "LD SP,nn", "LD (HL-),A", "INC SP", "INC (HL)", "DEC (HL)", "LD (HL),n", "SCF",
+    "JR C,e", "ADD HL,SP", "LD A,(HL-)", "DEC SP", "INC A", "DEC A", "LD A,n", "CCF",
+};
+
+static const char *const high[64] = {
+    "RET NZ", "POP BC", "JP NZ,nn", "JP nn", "CALL NZ,nn", "PUSH BC", "ADD A,n", "RST 00",
+    "RET Z", "RET", "JP Z,nn", "CB", "CALL Z,nn", "CALL nn", "ADC A,n", "RST 08",
+    "RET NC", "POP DE", "JP NC,nn", "-", "CALL NC,nn", "PUSH DE", "SUB n", "RST 10",
+    "RET C", "RETI", "JP C,nn", "-", "CALL C,nn", "-", "SBC A,n", "RST 18",
+    "LDH (n),A", "POP HL", "LD (C),A", "-", "-", "PUSH HL", "AND n", "RST 20",
+    "ADD SP,e", "JP (HL)", "LD (nn),A", "-", "-", "-", "XOR n", "RST 28",
+    "LDH A,(n)", "POP AF", "LD A,(C)", "DI", "-", "PUSH AF", "OR n", "RST 30",
+    "LD HL,SP+e", "LD SP,HL", "LD A,(nn)", "EI", "-", "-", "CP n", "RST 38",
+};
+
+const char *profileOpName(unsigned int op, char *buf)
+{
+    static const char *const regs[8] = { "B", "C", "D", "E", "H", "L", "(HL)", "A" };
+    static const char *const alu[8] = { "ADD A,", "ADC A,", "SUB ", "SBC A,", "AND ", "XOR ", "OR ", "CP " };
+    static const char *const shifts[8] = { "RLC", "RRC", "RL", "RR", "SLA", "SRA", "SWAP", "SRL" };
+    static const char *const bits[4] = { "", "BIT", "RES", "SET" };
+    const char *r = regs[op & 7];
+
+    if (op >= PROFILE_CB) {
+        op -= PROFILE_CB;
+        if (op < 0x40) sprintf(buf, "%s %s", shifts[op >> 3], r);
+        else sprintf(buf, "%s %d,%s", bits[op >> 6], (op >> 3) & 7, r);
+    } else if (op < 0x40) {
+        strcpy(buf, low[op]);
+    } else if (op == 0x76) {
+        strcpy(buf, "HALT");
+    } else if (op < 0x80) {
+        sprintf(buf, "LD %s,%s", regs[(op >> 3) & 7], r);
+    } else if (op < 0xC0) {
+        sprintf(buf, "%s%s", alu[(op >> 3) & 7], r);
+    } else {
+        strcpy(buf, high[op - 0xC0]);
+    }
+    return buf;
+}
+
+#ifdef VGB_PROFILE
+
+#include <stdlib.h>
+
+#include "cpu.h"
+#include "mmu.h"
+
+extern struct registers registers;
+
+#define NODES   16384
+#define DEPTH   256
+
+struct node {
+    unsigned short address; // 函数入口
+    int parent;
+    int child, sibling;
+    unsigned long long cycles;  // 自身的周期，不含调用的函数
+};
+
+struct frame {
+    int node;               // 调用者
+    unsigned short sp;
+};
+
+static unsigned long long flat[PROFILE_HALT + 1];
+static unsigned long long total;
+static struct node nodes[NODES];
+static int nodeN = 1;       // 0是root
+static int current;
+static struct frame stack[DEPTH];
+static int depth;
+
+static unsigned long long opCount[PROFILE_OPS], opCycles[PROFILE_OPS];
+static unsigned long long pairs[PROFILE_OPS][PROFILE_OPS];  // [前一条][这一条]，和opCount一样不会回绕
+static int prevOp = -1;     // 中断、HALT打断顺序执行
+
+static int child(int parent, unsigned short address)
+{
+    int n;
+
+    for (n = nodes[parent].child; n; n = nodes[n].sibling) {
+        if (nodes[n].address == address) return n;
+    }
+    if (nodeN == NODES) return parent;
+    n = nodeN++;
+    nodes[n].address = address;
+    nodes[n].parent = parent;
+    nodes[n].child = 0;
+    nodes[n].sibling = nodes[parent].child;
+    nodes[n].cycles = 0;
+    nodes[parent].child = n;
+    return n;
+}
+
+static void call(unsigned short address, unsigned short sp)
+{
+    if (depth == DEPTH) return;
+    stack[depth].node = current;
+    stack[depth].sp = sp;
+    depth++;
+    current = child(current, address);
+}
+
+static void ret(unsigned short sp)
+{
+    while (depth && stack[depth - 1].sp < sp) current = stack[--depth].node;
+    if (depth && stack[depth - 1].sp == sp) current = stack[--depth].node;
+}
+
+void profileStep(unsigned int pc, unsigned int op, unsigned short sp, unsigned int cycles)
+{
+    flat[pc] += cycles;
+    total += cycles;
+    if (pc == PROFILE_HALT) {           // 只在root;halt里出现
+        prevOp = -1;
+        return;
+    }
+    nodes[current].cycles += cycles;
+    opCount[op]++;
+    opCycles[op] += cycles;
+    if (prevOp >= 0) pairs[prevOp][op]++;
+    prevOp = op;
+
+    switch (op) {
+        case 0xC4: case 0xCC: case 0xCD: case 0xD4: case 0xDC:  // CALL
+        case 0xC7: case 0xCF: case 0xD7: case 0xDF:             // RST
+        case 0xE7: case 0xEF: case 0xF7: case 0xFF:
+            if (registers.SP == (unsigned short)(sp - 2)) call(registers.PC, registers.SP);
+            break;
+        case 0xC0: case 0xC8: case 0xC9: case 0xD0: case 0xD8: case 0xD9:  // RET/RETI
+            if (registers.SP == (unsigned short)(sp + 2)) ret(sp);
+            break;
+    }
+}
+
+void profileInterrupt(unsigned short address)
+{
+    prevOp = -1;
+    call(address, registers.SP);
+}
+
+void profileReset(void)
+{
+    memset(flat, 0, sizeof(flat));
+    total = 0;
+    memset(nodes, 0, sizeof(nodes));
+    nodeN = 1;
+    current = 0;
+    depth = 0;
+    memset(opCount, 0, sizeof(opCount));
+    memset(opCycles, 0, sizeof(opCycles));
+    memset(pairs, 0, sizeof(pairs));
+    prevOp = -1;
+}
+
+static const char *label(unsigned int address, char *buf)
+{
+    static const char *const regions[] = { "VRAM", "SRAM", "WRAM", "ECHO" };
+
+    if (address == PROFILE_HALT) return "halt";
+    if (address < 0x8000) sprintf(buf, "%02X:%04X", address >> 14, address);
+    else if (address >= 0xFF80) sprintf(buf, "HRAM:%04X", address);
+    else if (address >= 0xFE00) sprintf(buf, "%s:%04X", address >= 0xFF00 ? "IO" : "OAM", address);
+    else sprintf(buf, "%s:%04X", regions[(address - 0x8000) >> 13], address);
+    return buf;
+}
+
+struct entry {
+    unsigned int address;
+    unsigned long long cycles;
+};
+
+static int byCycles(const void *a, const void *b)
+{
+    unsigned long long x = ((const struct entry *)a)->cycles, y = ((const struct entry *)b)->cycles;
+
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+// 按周期从多到少列前top个
+static void writeTop(FILE *f, const char *title, struct entry *e, int n, int top)
+{
+    char buf[16];
+
+    qsort(e, n, sizeof(*e), byCycles);
+    fprintf(f, "%s\n", title);
+    for (int i = 0; i < n && i < top && e[i].cycles; i++) {
+        fprintf(f, "  %12llu %6.2f%%  %s\n", e[i].cycles, e[i].cycles * 100.0 / total, label(e[i].address, buf));
+    }
+}
+
+int profileWriteFlat(FILE *f, int top)
+{
+    struct entry *e = malloc((PROFILE_HALT + 1) * sizeof(*e));
+    int n = 0;
+
+    if (!e) return -1;
+    fprintf(f, "profile: %llu cycles, %d call tree nodes%s\n", total, nodeN, nodeN == NODES ? " (full)" : "");
+
+    // 函数：同一个入口的各个节点加起来，root和halt不算
+    for (unsigned int a = 0; a <= PROFILE_HALT; a++) {
+        e[a].address = a;
+        e[a].cycles = 0;
+    }
+    for (int i = 1; i < nodeN; i++) e[nodes[i].address].cycles += nodes[i].cycles;
+    writeTop(f, "self cycles by function:", e, PROFILE_HALT, top);
+
+    for (unsigned int a = 0; a <= PROFILE_HALT; a++) {
+        if (flat[a]) {
+            e[n].address = a;
+            e[n].cycles = flat[a];
+            n++;
+        }
+    }
+    writeTop(f, "cycles by address:", e, n, top);
+    free(e);
+    return 0;
+}
+
+static void writePath(FILE *f, int n)
+{
+    char buf[16];
+
+    if (n == 0) {
+        fputs("root", f);
+        return;
+    }
+    writePath(f, nodes[n].parent);
+    fprintf(f, ";%s", label(nodes[n].address, buf));
+}
+
+int profileWriteFolded(FILE *f)
+{
+    for (int i = 0; i < nodeN; i++) {
+        if (!nodes[i].cycles) continue;
+        writePath(f, i);
+        fprintf(f, " %llu\n", nodes[i].cycles);
+    }
+    if (flat[PROFILE_HALT]) fprintf(f, "root;halt %llu\n", flat[PROFILE_HALT]);
+    return 0;
+}
+
+// 按次数从多到少
+static int byCount(const void *a, const void *b)
+{
+    unsigned long long x = opCount[*(const int *)a], y = opCount[*(const int *)b];
+
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+static int byPairs(const void *a, const void *b)
+{
+    unsigned long long x = ((const unsigned long long *)pairs)[*(const int *)a], y = ((const unsigned long long *)pairs)[*(const int *)b];
+
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+int profileWriteOpcodes(FILE *f, int top)
+{
+    static int order[PROFILE_OPS * PROFILE_OPS];
+    unsigned long long count = 0, cycles = 0;
+    char a[16], b[16];
+    int n = 0;
+
+    for (int op = 0; op < PROFILE_OPS; op++) {
+        count += opCount[op];
+        cycles += opCycles[op];
+        if (opCount[op]) order[n++] = op;
+    }
+    if (!count) return 0;
+    qsort(order, n, sizeof(*order), byCount);
+
+    fprintf(f, "# %.16s: %llu instructions, %llu cycles, %d opcodes used\n", (const char *)&cart[0x134], count, cycles, n);
+    fprintf(f, "#        count      %%       cycles      %%  opcode\n");
+    for (int i = 0; i < n; i++) {
+        int op = order[i];
+        fprintf(f, "%14llu %6.2f %12llu %6.2f  %s%02X  %s\n", opCount[op], opCount[op] * 100.0 / count,
+                opCycles[op], opCycles[op] * 100.0 / cycles, op >= PROFILE_CB ? "CB " : "", op & 0xFF, profileOpName(op, a));
+    }
+
+    n = 0;
+    for (int i = 0; i < PROFILE_OPS * PROFILE_OPS; i++) {
+        if (((const unsigned long long *)pairs)[i]) order[n++] = i;
+    }
+    qsort(order, n, sizeof(*order), byPairs);
+    fprintf(f, "# pairs\n");
+    for (int i = 0; i < n && i < top; i++) {
+        int first = order[i] / PROFILE_OPS, second = order[i] % PROFILE_OPS;
+        unsigned long long c = pairs[first][second];
+        fprintf(f, "%14llu %6.2f  %s ; %s\n", c, c * 100.0 / count, profileOpName(first, a), profileOpName(second, b));
+    }
+    return 0;
+}
+
+#else
+
+void profileStep(unsigned int pc, unsigned int op, unsigned short sp, unsigned int cycles)
+{
+    (void)pc;
+    (void)op;
+    (void)sp;
+    (void)cycles;
+}
+
+void profileInterrupt(unsigned short address)
+{
+    (void)address;
+}
+
+void profileReset(void)
+{
+}
+
+int profileWriteFlat(FILE *f, int top)
+{
+    (void)f;
+    (void)top;
+    return -1;
+}
+
+int profileWriteFolded(FILE *f)
+{
+    (void)f;
+    return -1;
+}
+
+int profileWriteOpcodes(FILE *f, int top)
+{
+    (void)f;
+    (void)top;
+    return -1;
+}
+
+#endif
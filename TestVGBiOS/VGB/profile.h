@@ -0,0 +1,39 @@
+//
+//  profile.h
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+#ifndef profile_h
+#define profile_h
+
+#include <stdio.h>
+
+/*
+ 模拟代码的性能分析，编译时定义VGB_PROFILE才有。没有定义时cpuCycle和原来
+ 完全一样，下面的函数什么都不记，输出函数返回-1。
+ */
+
+// cpu.c的钩子：执行完一条指令（halted时pc为PROFILE_HALT），进入中断。
+// op为0x00-0xFF，CB前缀的指令为PROFILE_CB+第二个字节
+#define PROFILE_HALT    0x10000
+#define PROFILE_CB      0x100
+#define PROFILE_OPS     0x200
+void profileStep(unsigned int pc, unsigned int op, unsigned short sp, unsigned int cycles);
+void profileInterrupt(unsigned short address);
+
+void profileReset(void);
+
+// 按函数（CALL/RST/中断的目标）和按指令地址的周期，各列前top个
+int profileWriteFlat(FILE *f, int top);
+
+// 每个调用栈一行："root;01:4A3C;00:0040 周期"，给flamegraph.pl之类的工具
+int profileWriteFolded(FILE *f);
+
+// 各指令的执行次数和周期，按次数排序；然后是最常见的top个相邻指令对
+int profileWriteOpcodes(FILE *f, int top);
+const char *profileOpName(unsigned int op, char *buf);   // buf至少16字节
+
+#endif /* profile_h */
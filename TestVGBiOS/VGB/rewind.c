@@ -0,0 +1,313 @@
+//
+//  rewind.c
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+/*
+ 倒带：定期存的快照放在一块固定大小的环形内存里。
+
+ 快照按8字节一个字和本组的关键帧异或，只存不同的字：若干段
+ u16 相同的字数 | u16 不同的字数 | 异或后的字；关键帧就是和全0异或。
+ 一帧里变化的一般只有几百字节（工作内存、OAM、寄存器），显存大部分帧不动。
+
+ 关键帧和它后面的差分是一组，空间不够时从最老的一组整组丢掉。差分离关键帧越远
+ 越大，所以一组满REWIND_KEYFRAME个快照、或者超过预算的GROUP_SHARE分之一时
+ 就开始新的一组，腾空间永远不会丢到正在写的这一组。倒回最新的快照
+ 时需要它那一组的关键帧：`key`一直是最新一组解码好的关键帧，倒回到上一组时
+ 再解码那一组的关键帧。
+ */
+
+#include "rewind.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pace.h"
+#include "state.h"
+
+#define WORDS   ((int)((sizeof(struct machineState) + 7) / 8))
+#define GROUP_SHARE 4   // 一组最多占预算的几分之一
+
+union image {
+    struct machineState state;
+    uint64_t words[WORDS];
+};
+
+struct entry {
+    long offset;
+    long size;
+    int key;
+};
+
+static const uint64_t zero[WORDS];
+
+static union image *cur, *key;
+static int keyValid;            // key是最新一组的关键帧
+static unsigned char *data;     // 环形内存
+static unsigned char *scratch;  // 编码的中转，放得下最坏情况
+static long size;
+static struct entry *entries;
+static int cap, first, count;
+static long bytes;
+static int interval, wait, sinceKey;
+static long groupBytes;         // 最新一组已经占的字节
+
+static struct rewindStats stats;
+static unsigned long keyN, deltaN;
+static double keySum, deltaSum, captureSum, stepSum;
+
+static int64_t now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void rewindShutdown(void)
+{
+    free(cur);
+    free(key);
+    free(data);
+    free(scratch);
+    free(entries);
+    cur = key = NULL;
+    data = scratch = NULL;
+    entries = NULL;
+    count = 0;
+}
+
+int rewindInit(long budget, int frames)
+{
+    rewindShutdown();
+    rewindResetStats();
+    first = count = 0;
+    bytes = 0;
+    keyValid = 0;
+    wait = sinceKey = 0;
+    groupBytes = 0;
+    interval = frames > 0 ? frames : 1;
+    size = budget;
+    if (budget <= 0) return 0;
+
+    cap = (int)(budget / 32) + 1;   // 差分至少有一段，一般几百字节
+    cur = calloc(1, sizeof(*cur));
+    key = calloc(1, sizeof(*key));
+    data = malloc(budget);
+    scratch = malloc((long)WORDS * 12 + 8);
+    entries = malloc(cap * sizeof(*entries));
+    if (!cur || !key || !data || !scratch || !entries) {
+        rewindShutdown();
+        return -1;
+    }
+    return 0;
+}
+
+static struct entry *at(int i)
+{
+    return &entries[(first + i) % cap];
+}
+
+static long encode(unsigned char *out, const uint64_t *a, const uint64_t *b)
+{
+    unsigned char *p = out;
+    int i = 0;
+
+    while (i < WORDS) {
+        int s = i, l;
+
+        while (i < WORDS && a[i] == b[i]) i++;
+        if (i == WORDS) break;
+        l = i;
+        while (i < WORDS && a[i] != b[i]) i++;
+
+        p[0] = l - s;
+        p[1] = (l - s) >> 8;
+        p[2] = i - l;
+        p[3] = (i - l) >> 8;
+        p += 4;
+        for (int k = l; k < i; k++) {
+            uint64_t w = a[k] ^ b[k];
+            memcpy(p, &w, 8);
+            p += 8;
+        }
+    }
+    return p - out;
+}
+
+static void decode(uint64_t *dst, const uint64_t *ref, const unsigned char *p, long n)
+{
+    const unsigned char *end = p + n;
+    int i = 0;
+
+    if (dst != ref) memcpy(dst, ref, sizeof(union image));
+    while (p < end) {
+        int s = p[0] | p[1] << 8, l = p[2] | p[3] << 8;
+        p += 4;
+        i += s;
+        for (; l; l--, i++, p += 8) {
+            uint64_t w;
+            memcpy(&w, p, 8);
+            dst[i] ^= w;
+        }
+    }
+}
+
+// 丢掉最老的一组
+static void dropGroup(void)
+{
+    do {
+        bytes -= at(0)->size;
+        first = (first + 1) % cap;
+        count--;
+        stats.dropped++;
+    } while (count && !at(0)->key);
+    if (!count) keyValid = 0;
+}
+
+// 找一块n字节的连续空间，不够时丢老的组；比整个预算还大返回-1
+static long reserve(long n)
+{
+    if (n > size) return -1;
+    for (;;) {
+        struct entry *newest, *oldest;
+        long head;
+
+        if (!count) return 0;
+        if (count < cap) {
+            newest = at(count - 1);
+            oldest = at(0);
+            head = newest->offset + newest->size;
+            if (newest->offset >= oldest->offset) {
+                // 没有绕回：空闲的是[head, size)和[0, oldest)
+                if (size - head >= n) return head;
+                if (oldest->offset >= n) return 0;
+            } else if (oldest->offset - head >= n) {
+                return head;
+            }
+        }
+        dropGroup();
+    }
+}
+
+void rewindFrame(void)
+{
+    int64_t t0;
+    int isKey;
+    long n, offset;
+    struct entry *e;
+
+    if (!data || ++wait < interval) return;
+    wait = 0;
+    t0 = now();
+
+    stateSave(&cur->state);
+    isKey = !keyValid || sinceKey >= REWIND_KEYFRAME || groupBytes > size / GROUP_SHARE;
+    n = encode(scratch, cur->words, isKey ? zero : key->words);
+    offset = reserve(n);
+    if (!isKey && !keyValid) {
+        // 腾空间时把本组也丢了，改存关键帧
+        isKey = 1;
+        n = encode(scratch, cur->words, zero);
+        offset = reserve(n);
+    }
+    if (offset < 0) {
+        keyValid = 0;
+        stats.dropped++;
+        return;
+    }
+
+    memcpy(data + offset, scratch, n);
+    e = at(count++);
+    e->offset = offset;
+    e->size = n;
+    e->key = isKey;
+    bytes += n;
+    groupBytes = isKey ? n : groupBytes + n;
+
+    if (isKey) {
+        union image *t = key;
+        key = cur;
+        cur = t;
+        keyValid = 1;
+        sinceKey = 0;
+        stats.keyframes++;
+        keySum += n;
+        keyN++;
+    } else {
+        deltaSum += n;
+        deltaN++;
+    }
+    sinceKey++;
+    stats.captures++;
+
+    double us = (now() - t0) / 1e3;
+    captureSum += us;
+    if (us > stats.maxCaptureUs) stats.maxCaptureUs = us;
+}
+
+int rewindStep(void)
+{
+    int64_t t0;
+    struct entry *e;
+
+    if (!data || !count) return 0;
+    t0 = now();
+
+    e = at(count - 1);
+    if (e->key) {
+        decode(cur->words, zero, data + e->offset, e->size);
+    } else {
+        if (!keyValid) {
+            int k = count - 1;
+            while (!at(k)->key) k--;
+            decode(key->words, zero, data + at(k)->offset, at(k)->size);
+            keyValid = 1;
+        }
+        decode(cur->words, key->words, data + e->offset, e->size);
+    }
+    count--;
+    bytes -= e->size;
+    if (e->key) keyValid = 0;   // 这一组没了，再存要从关键帧开始
+    if (sinceKey > 0) sinceKey--;
+    groupBytes = groupBytes > e->size ? groupBytes - e->size : 0;
+
+    // 快照之后取出的按键不属于那个时间点
+    cur->state.core.input.pendingHead = 0;
+    cur->state.core.input.pendingN = 0;
+    stateLoad(&cur->state);
+    wait = 0;
+
+    stats.steps++;
+    stepSum += (now() - t0) / 1e3;
+    return 1;
+}
+
+int rewindFrames(void)
+{
+    return count * interval;
+}
+
+void rewindGetStats(struct rewindStats *s)
+{
+    *s = stats;
+    s->entries = count;
+    s->bytes = bytes;
+    s->budget = data ? size : 0;
+    s->keyBytes = keyN ? (long)(keySum / keyN) : 0;
+    s->deltaBytes = deltaN ? (long)(deltaSum / deltaN) : 0;
+    if (stats.captures) s->minuteBytes = (long)((keySum + deltaSum) / stats.captures * PACE_HZ * 60 / interval);
+    s->captureUs = stats.captures ? captureSum / stats.captures : 0;
+    s->stepUs = stats.steps ? stepSum / stats.steps : 0;
+}
+
+void rewindResetStats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+    keyN = deltaN = 0;
+    keySum = deltaSum = captureSum = stepSum = 0;
+}
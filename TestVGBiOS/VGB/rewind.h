@@ -0,0 +1,43 @@
+//
+//  rewind.h
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+#ifndef rewind_h
+#define rewind_h
+
+#define REWIND_KEYFRAME     60  // 每隔这么多个快照存一个关键帧
+#define REWIND_BUDGET       (4 << 20)   // 默认内存预算(字节)
+
+struct rewindStats {
+    unsigned long captures;
+    unsigned long keyframes;
+    unsigned long dropped;      // 预算不够丢掉的最老的快照
+    unsigned long steps;        // 倒回的次数
+    int entries;                // 现在环里的快照
+    long bytes;                 // 现在占用的字节
+    long budget;
+    long keyBytes;              // 关键帧平均字节数
+    long deltaBytes;            // 差分平均字节数
+    long minuteBytes;           // 按平均大小算，倒带一分钟要的字节数
+    double captureUs;           // 每次存快照的平均耗时
+    double maxCaptureUs;
+    double stepUs;              // 每次倒回(解码+读档)的平均耗时
+};
+
+// budget为0关闭；每interval帧存一个快照。分配一次，之后存取都不分配内存
+int rewindInit(long budget, int interval);
+void rewindShutdown(void);
+
+// 以下在模拟线程、帧之间调用
+void rewindFrame(void);     // 每帧VBlank时调用，到了间隔存快照
+int rewindStep(void);       // 读回最近的快照并把它移出环，没有了返回0
+int rewindFrames(void);     // 还能倒回的帧数
+
+void rewindGetStats(struct rewindStats *stats);
+void rewindResetStats(void);
+
+#endif /* rewind_h */
@@ -0,0 +1,425 @@
+//
+//  scale.c
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+/*
+ 放大滤镜表：最近邻、Scale2x/3x(EPX/AdvMAME)、xBR(level 1)和HQX。
+ 所有滤镜都按矩形工作，配合lcdDirtyRects只处理变化区域；图像边缘外的
+ 邻居取边缘像素。
+ */
+
+#include "scale.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hqx.h"
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SCALE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SCALE_SSE2 1
+#endif
+
+#define ROW(p, rb, y)   ((uint32_t *)((uint8_t *)(p) + (long)(y) * (rb)))
+
+static inline int clampi(int v, int lo, int hi)
+{
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+//////////////////////////////////////////////////
+// 最近邻
+
+static void nearest(int n, const uint32_t *src, int srb, uint32_t *dst, int drb, int x0, int y0, int x1, int y1)
+{
+    for (int y = y0; y < y1; y++) {
+        const uint32_t *s = ROW(src, srb, y);
+        uint32_t *d = ROW(dst, drb, y * n) + x0 * n;
+        int x = x0;
+
+#if SCALE_NEON
+        for (; n == 2 && x + 4 <= x1; x += 4, d += 8) {
+            uint32x4x2_t z = vzipq_u32(vld1q_u32(s + x), vld1q_u32(s + x));
+            vst1q_u32(d, z.val[0]);
+            vst1q_u32(d + 4, z.val[1]);
+        }
+        for (; n == 4 && x + 4 <= x1; x += 4, d += 16) {
+            uint32x4_t v = vld1q_u32(s + x);
+            vst1q_u32(d, vdupq_laneq_u32(v, 0));
+            vst1q_u32(d + 4, vdupq_laneq_u32(v, 1));
+            vst1q_u32(d + 8, vdupq_laneq_u32(v, 2));
+            vst1q_u32(d + 12, vdupq_laneq_u32(v, 3));
+        }
+#elif SCALE_SSE2
+        for (; n == 2 && x + 4 <= x1; x += 4, d += 8) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(s + x));
+            _mm_storeu_si128((__m128i *)d, _mm_unpacklo_epi32(v, v));
+            _mm_storeu_si128((__m128i *)(d + 4), _mm_unpackhi_epi32(v, v));
+        }
+        for (; n == 4 && x + 4 <= x1; x += 4, d += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(s + x));
+            _mm_storeu_si128((__m128i *)d, _mm_shuffle_epi32(v, 0x00));
+            _mm_storeu_si128((__m128i *)(d + 4), _mm_shuffle_epi32(v, 0x55));
+            _mm_storeu_si128((__m128i *)(d + 8), _mm_shuffle_epi32(v, 0xAA));
+            _mm_storeu_si128((__m128i *)(d + 12), _mm_shuffle_epi32(v, 0xFF));
+        }
+#endif
+        for (; x < x1; x++) {
+            for (int k = 0; k < n; k++) *d++ = s[x];
+        }
+
+        // 其余n-1行与第一行相同
+        for (int k = 1; k < n; k++) {
+            memcpy(ROW(dst, drb, y * n + k) + x0 * n, ROW(dst, drb, y * n) + x0 * n, (x1 - x0) * n * 4);
+        }
+    }
+}
+
+static void nearest2x(const uint32_t *src, int srb, uint32_t *dst, int drb, int width, int height, int x0, int y0, int x1, int y1)
+{
+    (void)width;
+    (void)height;
+    nearest(2, src, srb, dst, drb, x0, y0, x1, y1);
+}
+
+static void nearest3x(const uint32_t *src, int srb, uint32_t *dst, int drb, int width, int height, int x0, int y0, int x1, int y1)
+{
+    (void)width;
+    (void)height;
+    nearest(3, src, srb, dst, drb, x0, y0, x1, y1);
+}
+
+static void nearest4x(const uint32_t *src, int srb, uint32_t *dst, int drb, int width, int height, int x0, int y0, int x1, int y1)
+{
+    (void)width;
+    (void)height;
+    nearest(4, src, srb, dst, drb, x0, y0, x1, y1);
+}
+
+//////////////////////////////////////////////////
+// Scale2x/Scale3x
+//   A B C
+//   D E F
+//   G H I
+
+static void scale2x(const uint32_t *src, int srb, uint32_t *dst, int drb, int width, int height, int x0, int y0, int x1, int y1)
+{
+    for (int y = y0; y < y1; y++) {
+        const uint32_t *up = ROW(src, srb, y > 0 ? y - 1 : y);
+        const uint32_t *s = ROW(src, srb, y);
+        const uint32_t *dn = ROW(src, srb, y < height - 1 ? y + 1 : y);
+        uint32_t *d0 = ROW(dst, drb, y * 2);
+        uint32_t *d1 = ROW(dst, drb, y * 2 + 1);
+        int x = x0;
+
+        for (;;) {
+            // 左右两端要取边缘像素，走标量
+            if (x >= x1) break;
+            if (x > 0 && x + 4 < width && x + 4 <= x1) {
+#if SCALE_NEON
+                uint32x4_t b = vld1q_u32(up + x), h = vld1q_u32(dn + x);
+                uint32x4_t d = vld1q_u32(s + x - 1), e = vld1q_u32(s + x), f = vld1q_u32(s + x + 1);
+                uint32x4_t on = vbicq_u32(vmvnq_u32(vceqq_u32(b, h)), vceqq_u32(d, f));
+                uint32x4_t e0 = vbslq_u32(vandq_u32(on, vceqq_u32(d, b)), d, e);
+                uint32x4_t e1 = vbslq_u32(vandq_u32(on, vceqq_u32(b, f)), f, e);
+                uint32x4_t e2 = vbslq_u32(vandq_u32(on, vceqq_u32(d, h)), d, e);
+                uint32x4_t e3 = vbslq_u32(vandq_u32(on, vceqq_u32(h, f)), f, e);
+                uint32x4x2_t t = vzipq_u32(e0, e1), u = vzipq_u32(e2, e3);
+                vst1q_u32(d0 + x * 2, t.val[0]);
+                vst1q_u32(d0 + x * 2 + 4, t.val[1]);
+                vst1q_u32(d1 + x * 2, u.val[0]);
+                vst1q_u32(d1 + x * 2 + 4, u.val[1]);
+                x += 4;
+                continue;
+#elif SCALE_SSE2
+                __m128i b = _mm_loadu_si128((const __m128i *)(up + x)), h = _mm_loadu_si128((const __m128i *)(dn + x));
+                __m128i d = _mm_loadu_si128((const __m128i *)(s + x - 1)), e = _mm_loadu_si128((const __m128i *)(s + x));
+                __m128i f = _mm_loadu_si128((const __m128i *)(s + x + 1));
+                __m128i off = _mm_or_si128(_mm_cmpeq_epi32(b, h), _mm_cmpeq_epi32(d, f));
+                __m128i m0 = _mm_andnot_si128(off, _mm_cmpeq_epi32(d, b));
+                __m128i m1 = _mm_andnot_si128(off, _mm_cmpeq_epi32(b, f));
+                __m128i m2 = _mm_andnot_si128(off, _mm_cmpeq_epi32(d, h));
+                __m128i m3 = _mm_andnot_si128(off, _mm_cmpeq_epi32(h, f));
+                __m128i e0 = _mm_or_si128(_mm_and_si128(m0, d), _mm_andnot_si128(m0, e));
+                __m128i e1 = _mm_or_si128(_mm_and_si128(m1, f), _mm_andnot_si128(m1, e));
+                __m128i e2 = _mm_or_si128(_mm_and_si128(m2, d), _mm_andnot_si128(m2, e));
+                __m128i e3 = _mm_or_si128(_mm_and_si128(m3, f), _mm_andnot_si128(m3, e));
+                _mm_storeu_si128((__m128i *)(d0 + x * 2), _mm_unpacklo_epi32(e0, e1));
+                _mm_storeu_si128((__m128i *)(d0 + x * 2 + 4), _mm_unpackhi_epi32(e0, e1));
+                _mm_storeu_si128((__m128i *)(d1 + x * 2), _mm_unpacklo_epi32(e2, e3));
+                _mm_storeu_si128((__m128i *)(d1 + x * 2 + 4), _mm_unpackhi_epi32(e2, e3));
+                x += 4;
+                continue;
+#endif
+            }
+            {
+                uint32_t b = up[x], h = dn[x], e = s[x];
+                uint32_t d = s[x > 0 ? x - 1 : x], f = s[x < width - 1 ? x + 1 : x];
+
+                if (b != h && d != f) {
+                    d0[x * 2] = d == b ? d : e;
+                    d0[x * 2 + 1] = b == f ? f : e;
+                    d1[x * 2] = d == h ? d : e;
+                    d1[x * 2 + 1] = h == f ? f : e;
+                } else {
+                    d0[x * 2] = d0[x * 2 + 1] = d1[x * 2] = d1[x * 2 + 1] = e;
+                }
+                x++;
+            }
+        }
+    }
+}
+
+static void scale3x(const uint32_t *src, int srb, uint32_t *dst, int drb, int width, int height, int x0, int y0, int x1, int y1)
+{
+    for (int y = y0; y < y1; y++) {
+        const uint32_t *up = ROW(src, srb, y > 0 ? y - 1 : y);
+        const uint32_t *s = ROW(src, srb, y);
+        const uint32_t *dn = ROW(src, srb, y < height - 1 ? y + 1 : y);
+        uint32_t *o0 = ROW(dst, drb, y * 3);
+        uint32_t *o1 = ROW(dst, drb, y * 3 + 1);
+        uint32_t *o2 = ROW(dst, drb, y * 3 + 2);
+
+        for (int x = x0; x < x1; x++) {
+            int l = x > 0 ? x - 1 : x;
+            int r = x < width - 1 ? x + 1 : x;
+            uint32_t a = up[l], b = up[x], c = up[r];
+            uint32_t d = s[l], e = s[x], f = s[r];
+            uint32_t g = dn[l], h = dn[x], i = dn[r];
+            uint32_t *p0 = o0 + x * 3, *p1 = o1 + x * 3, *p2 = o2 + x * 3;
+
+            if (b != h && d != f) {
+                p0[0] = d == b ? d : e;
+                p0[1] = (d == b && e != c) || (b == f && e != a) ? b : e;
+                p0[2] = b == f ? f : e;
+                p1[0] = (d == b && e != g) || (d == h && e != a) ? d : e;
+                p1[1] = e;
+                p1[2] = (b == f && e != i) || (h == f && e != c) ? f : e;
+                p2[0] = d == h ? d : e;
+                p2[1] = (d == h && e != i) || (h == f && e != g) ? h : e;
+                p2[2] = h == f ? f : e;
+            } else {
+                p0[0] = p0[1] = p0[2] = e;
+                p1[0] = p1[1] = p1[2] = e;
+                p2[0] = p2[1] = p2[2] = e;
+            }
+        }
+    }
+}
+
+//////////////////////////////////////////////////
+// xBR level 1, 2x
+//        A1 B1 C1
+//     A0 A  B  C  C4
+//     D0 D  E  F  F4
+//     G0 G  H  I  I4
+//        G5 H5 I5
+
+static uint32_t *yuvBuf;    // 与源图同尺寸的YUV，只填需要的区域
+static int yuvSize;
+
+static inline uint32_t toYUV(uint32_t c)
+{
+    int r = c & 0xFF, g = (c >> 8) & 0xFF, b = (c >> 16) & 0xFF;
+    int y = (306 * r + 601 * g + 117 * b) >> 10;
+    int u = (-173 * r - 339 * g + 512 * b + (128 << 10)) >> 10;
+    int v = (512 * r - 429 * g - 83 * b + (128 << 10)) >> 10;
+    return (y << 16) | (u << 8) | v;
+}
+
+// 加权YUV距离
+static inline int yuvDist(uint32_t a, uint32_t b)
+{
+    return 48 * abs((int)(a >> 16) - (int)(b >> 16)) +
+           7 * abs((int)((a >> 8) & 0xFF) - (int)((b >> 8) & 0xFF)) +
+           6 * abs((int)(a & 0xFF) - (int)(b & 0xFF));
+}
+
+static inline uint32_t avg(uint32_t a, uint32_t b)
+{
+    return ((a & 0xFEFEFEFE) >> 1) + ((b & 0xFEFEFEFE) >> 1) + (a & b & 0x01010101);
+}
+
+// 5x5邻域(E在12)中各角用到的像素：E B C D F G H I F4 I4 H5 I5，以右下角为准镜像
+static const unsigned char corners[4][12] = {
+    {12, 17, 16, 13, 11,  8,  7,  6, 10,  5,  2,  1},   // 左上
+    {12, 17, 18, 11, 13,  6,  7,  8, 14,  9,  2,  3},   // 右上
+    {12,  7,  6, 13, 11, 18, 17, 16, 10, 15, 22, 21},   // 左下
+    {12,  7,  8, 11, 13, 16, 17, 18, 14, 19, 22, 23},   // 右下
+};
+
+static inline uint32_t xbrCorner(const uint32_t *p, const uint32_t *yv, const unsigned char *k)
+{
+    enum {E, B, C, D, F, G, H, I, F4, I4, H5, I5};
+    int we, wi;
+
+    if (p[k[E]] == p[k[H]] || p[k[E]] == p[k[F]]) return p[k[E]];
+    we = yuvDist(yv[k[E]], yv[k[C]]) + yuvDist(yv[k[E]], yv[k[G]]) + yuvDist(yv[k[I]], yv[k[H5]]) +
+         yuvDist(yv[k[I]], yv[k[F4]]) + 4 * yuvDist(yv[k[H]], yv[k[F]]);
+    wi = yuvDist(yv[k[H]], yv[k[D]]) + yuvDist(yv[k[H]], yv[k[I5]]) + yuvDist(yv[k[F]], yv[k[I4]]) +
+         yuvDist(yv[k[F]], yv[k[B]]) + 4 * yuvDist(yv[k[E]], yv[k[I]]);
+    if (we >= wi) return p[k[E]];
+    return avg(p[k[E]], yuvDist(yv[k[E]], yv[k[F]]) <= yuvDist(yv[k[E]], yv[k[H]]) ? p[k[F]] : p[k[H]]);
+}
+
+static void xbr2x(const uint32_t *src, int srb, uint32_t *dst, int drb, int width, int height, int x0, int y0, int x1, int y1)
+{
+    int yy0 = clampi(y0 - 2, 0, height - 1), yy1 = clampi(y1 + 2, 0, height);
+    int xx0 = clampi(x0 - 2, 0, width - 1), xx1 = clampi(x1 + 2, 0, width);
+
+    if (yuvSize < width * height) {
+        uint32_t *buf = realloc(yuvBuf, (size_t)width * height * 4);
+        if (!buf) return;
+        yuvBuf = buf;
+        yuvSize = width * height;
+    }
+
+    // 先把区域加两圈邻居转成YUV，避免每个距离都重算
+    for (int y = yy0; y < yy1; y++) {
+        const uint32_t *s = ROW(src, srb, y);
+        for (int x = xx0; x < xx1; x++) {
+            yuvBuf[y * width + x] = x > xx0 && s[x] == s[x - 1] ? yuvBuf[y * width + x - 1] : toYUV(s[x]);
+        }
+    }
+
+    for (int y = y0; y < y1; y++) {
+        const uint32_t *r[5];
+        const uint32_t *ry[5];
+        uint32_t *o0 = ROW(dst, drb, y * 2);
+        uint32_t *o1 = ROW(dst, drb, y * 2 + 1);
+
+        for (int k = 0; k < 5; k++) {
+            int sy = clampi(y + k - 2, 0, height - 1);
+            r[k] = ROW(src, srb, sy);
+            ry[k] = yuvBuf + sy * width;
+        }
+
+        for (int x = x0; x < x1; x++) {
+            int sx[5] = {clampi(x - 2, 0, width - 1), clampi(x - 1, 0, width - 1), x,
+                         clampi(x + 1, 0, width - 1), clampi(x + 2, 0, width - 1)};
+            uint32_t e = r[2][x], b = r[1][x], d = r[2][sx[1]], f = r[2][sx[3]], h = r[3][x];
+            uint32_t p[25], yv[25];
+
+            // 四个角都挨着同色像素时不用插值（平坦区域大多如此）
+            if ((e == b || e == d) && (e == b || e == f) && (e == h || e == d) && (e == h || e == f)) {
+                o0[x * 2] = o0[x * 2 + 1] = o1[x * 2] = o1[x * 2 + 1] = e;
+                continue;
+            }
+
+            for (int j = 0; j < 5; j++) {
+                for (int i = 0; i < 5; i++) {
+                    p[j * 5 + i] = r[j][sx[i]];
+                    yv[j * 5 + i] = ry[j][sx[i]];
+                }
+            }
+
+            o0[x * 2]     = xbrCorner(p, yv, corners[0]);
+            o0[x * 2 + 1] = xbrCorner(p, yv, corners[1]);
+            o1[x * 2]     = xbrCorner(p, yv, corners[2]);
+            o1[x * 2 + 1] = xbrCorner(p, yv, corners[3]);
+        }
+    }
+}
+
+//////////////////////////////////////////////////
+// HQX
+
+static void hq2x(const uint32_t *src, int srb, uint32_t *dst, int drb, int width, int height, int x0, int y0, int x1, int y1)
+{
+    //4色以内的画面直接查邻域缓存
+    if (!hq2x_32_rb_cached_rect((uint32_t *)src, srb, dst, drb, width, height, x0, y0, x1, y1))
+        hqx_32_rb_parallel_rect(2, (uint32_t *)src, srb, dst, drb, width, height, x0, y0, x1, y1);
+}
+
+static void hq3x(const uint32_t *src, int srb, uint32_t *dst, int drb, int width, int height, int x0, int y0, int x1, int y1)
+{
+    hqx_32_rb_parallel_rect(3, (uint32_t *)src, srb, dst, drb, width, height, x0, y0, x1, y1);
+}
+
+static void hq4x(const uint32_t *src, int srb, uint32_t *dst, int drb, int width, int height, int x0, int y0, int x1, int y1)
+{
+    hqx_32_rb_parallel_rect(4, (uint32_t *)src, srb, dst, drb, width, height, x0, y0, x1, y1);
+}
+
+//////////////////////////////////////////////////
+
+static const struct scaler scalers[] = {
+    {"nearest2x", 2, 0, nearest2x},
+    {"nearest3x", 3, 0, nearest3x},
+    {"nearest4x", 4, 0, nearest4x},
+    {"scale2x",   2, 1, scale2x},
+    {"scale3x",   3, 1, scale3x},
+    {"xbr2x",     2, 2, xbr2x},
+    {"hq2x",      2, 1, hq2x},
+    {"hq3x",      3, 1, hq3x},
+    {"hq4x",      4, 1, hq4x},
+};
+
+int scalerCount(void)
+{
+    return sizeof(scalers) / sizeof(scalers[0]);
+}
+
+const struct scaler* scalerGet(int i)
+{
+    if (i < 0 || i >= scalerCount()) return NULL;
+    return &scalers[i];
+}
+
+const struct scaler* scalerFind(const char *name)
+{
+    for (int i = 0; i < scalerCount(); i++) {
+        if (!strcmp(scalers[i].name, name)) return &scalers[i];
+    }
+    return NULL;
+}
+
+const struct scaler* scalerFit(const char *family, int viewW, int viewH, int width, int height)
+{
+    const struct scaler *best = NULL;
+    size_t len = strlen(family);
+
+    for (int i = 0; i < scalerCount(); i++) {
+        const struct scaler *s = &scalers[i];
+        if (strncmp(s->name, family, len) || s->name[len] < '0' || s->name[len] > '9') continue;
+        if (width * s->scale > viewW || height * s->scale > viewH) continue;
+        if (!best || s->scale > best->scale) best = s;
+    }
+    return best;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+double scalerBenchmark(const struct scaler *s, const uint32_t *src, int width, int height, int frames)
+{
+    int drb = width * s->scale * 4;
+    uint32_t *dst = malloc((size_t)drb * height * s->scale);
+    double t;
+
+    if (!dst || frames < 1) {
+        free(dst);
+        return 0;
+    }
+
+    s->run(src, width * 4, dst, drb, width, height, 0, 0, width, height);//预热（缓存、线程池）
+    t = now();
+    for (int i = 0; i < frames; i++) {
+        s->run(src, width * 4, dst, drb, width, height, 0, 0, width, height);
+    }
+    t = now() - t;
+    free(dst);
+    return t / frames;
+}
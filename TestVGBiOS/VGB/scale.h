@@ -0,0 +1,36 @@
+//
+//  scale.h
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+#ifndef scale_h
+#define scale_h
+
+#include <stdint.h>
+
+#define SCALE_MAX   4   // 最大放大倍数，宿主按这个分配输出缓冲
+
+// 只处理源像素[x0,x1) x [y0,y1)，邻域仍然从整张src读取；srb/drb为每行字节数
+typedef void (*scaleFunc)(const uint32_t *src, int srb, uint32_t *dst, int drb, int width, int height, int x0, int y0, int x1, int y1);
+
+struct scaler {
+    const char *name;   // 族名+倍数，如"nearest2x"、"hq3x"
+    int scale;
+    int border;         // 输出依赖的邻域半径，脏矩形要外扩这么多
+    scaleFunc run;
+};
+
+int scalerCount(void);
+const struct scaler* scalerGet(int i);
+const struct scaler* scalerFind(const char *name);
+
+// 整数倍适配：family族中能放进viewW x viewH的最大倍数，没有则返回NULL
+const struct scaler* scalerFit(const char *family, int viewW, int viewH, int width, int height);
+
+// 整帧缩放frames次，返回每帧纳秒数
+double scalerBenchmark(const struct scaler *s, const uint32_t *src, int width, int height, int frames);
+
+#endif /* scale_h */
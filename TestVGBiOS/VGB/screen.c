@@ -0,0 +1,139 @@
+//
+//  screen.c
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+/*
+ 帧输出流程：lcd的变化区域 -> (缩放) -> 呈现缓冲 -> 宿主。
+ 不缩放时lcd不输出RGB，直接从索引帧缓冲转换变化区域；缩放时lcd逐行写入
+ pic_mem_orgl，再由滤镜把变化区域画进呈现缓冲。平台相关的只有宿主怎么取帧。
+ */
+
+#include "screen.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "counters.h"
+#include "hqx.h"
+#include "latency.h"
+#include "lcd.h"
+#include "present.h"
+#include "video.h"
+
+static uint8_t pic_mem_orgl[SCREEN_WIDTH * SCREEN_HEIGHT * 4];
+static int out_format;
+static const struct scaler *scaler;         //当前滤镜，NULL为不缩放
+//宿主线程请求，模拟线程在帧结束时取走
+static const struct scaler *_Atomic scaler_next;
+static atomic_int scaler_change;
+static atomic_int scaler_bench;
+
+//lcd的输出目标，换了之后所有行都会重画
+static void setTarget(void)
+{
+    if (!scaler) {
+        videoSetTarget(NULL, 0, out_format);
+    } else {
+        //先整帧转换一次，还没重画的行也和索引帧缓冲一致
+        videoConvert(getPixels(), pic_mem_orgl, VIDEO_RGBA8888, SCREEN_WIDTH * SCREEN_HEIGHT);
+        videoSetTarget(pic_mem_orgl, SCREEN_WIDTH*4, VIDEO_RGBA8888);
+    }
+    presentInvalidate(SCREEN_WIDTH, SCREEN_HEIGHT);
+}
+
+//在模拟线程里跑：滤镜共用缓存和线程池
+static void benchmark(void)
+{
+    static uint32_t frame[SCREEN_WIDTH * SCREEN_HEIGHT];
+
+    videoConvert(getPixels(), frame, VIDEO_RGBA8888, SCREEN_WIDTH * SCREEN_HEIGHT);
+    for (int i = 0; i < scalerCount(); i++) {
+        const struct scaler *s = scalerGet(i);
+        fprintf(stderr, "scaler %s: %.0f ns/frame\n", s->name, scalerBenchmark(s, frame, SCREEN_WIDTH, SCREEN_HEIGHT, 100));
+    }
+}
+
+int screenInit(const char *name, int format, void *memory)
+{
+    hqxInit();
+
+    out_format = format;
+    scaler = name ? scalerFind(name) : NULL;
+    if (presentInit(SCREEN_BUFFER_SIZE, memory) != 0) return -1;
+    setTarget();
+    return 0;
+}
+
+static void drawRect(struct presentFrame *frame, const struct lcdRect *r)
+{
+    if (!scaler) {
+        const unsigned char *src = getPixels();
+        int bpp = videoBytesPerPixel(frame->format);
+
+        for (int y = r->y0; y < r->y1; y++) {
+            videoConvert(src + y*SCREEN_WIDTH + r->x0, frame->pixels + (long)y*frame->stride + r->x0*bpp, frame->format, r->x1 - r->x0);
+        }
+    } else {
+        //按滤镜的邻域外扩（周围像素的插值也受影响）
+        int b = scaler->border;
+        int x0 = r->x0 > b ? r->x0 - b : 0;
+        int y0 = r->y0 > b ? r->y0 - b : 0;
+        int x1 = r->x1 < SCREEN_WIDTH - b ? r->x1 + b : SCREEN_WIDTH;
+        int y1 = r->y1 < SCREEN_HEIGHT - b ? r->y1 + b : SCREEN_HEIGHT;
+
+        scaler->run((uint32_t*)pic_mem_orgl, SCREEN_WIDTH*4, (uint32_t*)frame->pixels, frame->stride, SCREEN_WIDTH, SCREEN_HEIGHT, x0, y0, x1, y1);
+    }
+}
+
+int screenFrame(void)
+{
+    struct lcdRect rects[LCD_MAX_RECTS];
+    struct lcdRect damage[PRESENT_MAX_DAMAGE];
+    struct presentFrame frame;
+    int n = lcdDirtyRects(rects, LCD_MAX_RECTS);//画面没有变化时不发布新帧
+
+    if (n) {
+        int nd = presentBegin(rects, n, &frame, damage);
+        int scale = scaler ? scaler->scale : 1;
+
+        frame.width = SCREEN_WIDTH * scale;
+        frame.height = SCREEN_HEIGHT * scale;
+        frame.format = scaler ? VIDEO_RGBA8888 : out_format;
+        frame.stride = frame.width * videoBytesPerPixel(frame.format);
+
+        //只画这块缓冲缺的区域，其余部分保留它上次的内容
+        TIME_BEGIN(t);
+        for (int i = 0; i < nd; i++) drawRect(&frame, &damage[i]);
+        TIME_END(t, drawSeconds);
+        COUNT(draws);
+        presentEnd(&frame);
+    }
+    latencyFrame(n ? frame.fence : 0);
+
+    if (atomic_exchange_explicit(&scaler_bench, 0, memory_order_acquire)) {
+        benchmark();
+    }
+
+    if (atomic_exchange_explicit(&scaler_change, 0, memory_order_acquire)) {
+        scaler = atomic_load_explicit(&scaler_next, memory_order_relaxed);
+        setTarget();
+    }
+
+    return n > 0;
+}
+
+void screenSetScaler(const struct scaler *s)
+{
+    atomic_store_explicit(&scaler_next, s, memory_order_relaxed);
+    atomic_store_explicit(&scaler_change, 1, memory_order_release);
+}
+
+void screenBenchmark(void)
+{
+    atomic_store_explicit(&scaler_bench, 1, memory_order_release);
+}
@@ -0,0 +1,31 @@
+//
+//  screen.h
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+#ifndef screen_h
+#define screen_h
+
+#include "scale.h"
+
+#define SCREEN_WIDTH    160
+#define SCREEN_HEIGHT   144
+
+// 每块呈现缓冲的字节数（按最大放大倍数）
+#define SCREEN_BUFFER_SIZE  (SCREEN_WIDTH * SCALE_MAX * SCREEN_HEIGHT * SCALE_MAX * 4)
+
+// scaler为NULL时不缩放，直接输出format格式；缩放时固定为32位
+// memory为NULL时自己分配，否则是PRESENT_BUFFERS*SCREEN_BUFFER_SIZE字节
+int screenInit(const char *scaler, int format, void *memory);
+
+// 在wnd_draw里调用：把本帧变化的区域画进一块呈现缓冲并发布，返回是否有新帧
+int screenFrame(void);
+
+// 以下在帧结束时生效，可以在任意线程调用
+void screenSetScaler(const struct scaler *s);
+void screenBenchmark(void);//给所有滤镜跑分，输出到stderr
+
+#endif /* screen_h */
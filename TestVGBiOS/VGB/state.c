@@ -0,0 +1,371 @@
+//
+//  state.c
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+/*
+ 机器快照：cpu、中断、定时器、lcd寄存器和mmu里的内存，外加lcd.c和input.c
+ 内部的状态。卡带ROM只读，不在快照里；lcd的索引帧缓冲是输出，读档后重新渲染。
+
+ 存档文件按fields表逐个字段直接在全局结构和缓冲之间转换，不经过中间的
+ machineState，也不分配内存。整数按标签规定的宽度存小端，和结构体的布局无关。
+ */
+
+#include "state.h"
+
+#include <string.h>
+
+#include "hash.h"
+#include "mmu.h"
+
+extern struct registers registers;
+extern struct LCD LCD;
+extern struct LCDC LCDC;
+extern struct LCDS LCDS;
+
+void stateSaveCore(struct machineCore *core)
+{
+    core->registers = registers;
+    core->interrupt = interrupt;
+    core->timer = timer;
+    core->LCD = LCD;
+    core->LCDC = LCDC;
+    core->LCDS = LCDS;
+    lcdSaveState(&core->lcd);
+    inputSaveState(&core->input);
+}
+
+void stateLoadCore(const struct machineCore *core)
+{
+    registers = core->registers;
+    interrupt = core->interrupt;
+    timer = core->timer;
+    LCD = core->LCD;
+    LCDC = core->LCDC;
+    LCDS = core->LCDS;
+    lcdLoadState(&core->lcd);
+    inputLoadState(&core->input);
+}
+
+void stateSave(struct machineState *state)
+{
+    stateSaveCore(&state->core);
+    memcpy(state->vram, vram, sizeof(state->vram));
+    memcpy(state->sram, sram, sizeof(state->sram));
+    memcpy(state->wram, wram, sizeof(state->wram));
+    memcpy(state->oam, oam, sizeof(state->oam));
+    memcpy(state->io, io, sizeof(state->io));
+    memcpy(state->hram, hram, sizeof(state->hram));
+}
+
+void stateLoad(const struct machineState *state)
+{
+    memcpy(vram, state->vram, sizeof(state->vram));
+    memcpy(sram, state->sram, sizeof(state->sram));
+    memcpy(wram, state->wram, sizeof(state->wram));
+    memcpy(oam, state->oam, sizeof(state->oam));
+    memcpy(io, state->io, sizeof(state->io));
+    memcpy(hram, state->hram, sizeof(state->hram));
+    memTouchAll();
+    stateLoadCore(&state->core);
+}
+
+///////////////////////////////////////////////
+
+#define FIELD_RAW   0   // 字节数组，原样存
+
+struct field {
+    unsigned short tag;
+    void *ptr;
+    unsigned short size;    // 内存里的字节数
+    unsigned char wire;     // 存档里整数的字节数，FIELD_RAW为数组
+    unsigned char since;    // 从哪个版本开始有
+};
+
+// lcd.c和input.c内部状态的中转
+static struct lcdState lcdStage;
+static struct inputState inputStage;
+static unsigned char romStage[0x150 - 0x134];
+
+#define F(tag, var, wire)   { tag, &(var), sizeof(var), wire, 1 }
+#define A(tag, var)         { tag, (var), sizeof(var), FIELD_RAW, 1 }
+
+static const struct field fields[] = {
+    A(0x0001, romStage),    // 卡带头0134-014F：标题到全局校验和
+
+    F(0x0101, registers.A, 1),
+    F(0x0102, registers.F, 1),
+    F(0x0103, registers.B, 1),
+    F(0x0104, registers.C, 1),
+    F(0x0105, registers.D, 1),
+    F(0x0106, registers.E, 1),
+    F(0x0107, registers.H, 1),
+    F(0x0108, registers.L, 1),
+    F(0x0109, registers.SP, 2),
+    F(0x010A, registers.PC, 2),
+    F(0x010B, registers.cycles, 4),
+    F(0x010C, registers.halted, 1),
+
+    F(0x0201, interrupt.master, 1),
+    F(0x0202, interrupt.enable, 1),
+    F(0x0203, interrupt.flags, 1),
+    F(0x0204, interrupt.pending, 1),
+
+    F(0x0301, timer.div, 4),
+    F(0x0302, timer.tima, 4),
+    F(0x0303, timer.tma, 4),
+    F(0x0304, timer.tac, 1),
+    F(0x0305, timer.speed, 4),
+    F(0x0306, timer.started, 4),
+    F(0x0307, timer.tick, 4),
+    F(0x0308, timer.last, 4),
+    F(0x0309, timer.change, 4),
+
+    F(0x0401, LCD.windowX, 4),
+    F(0x0402, LCD.windowY, 4),
+    F(0x0403, LCD.scrollX, 4),
+    F(0x0404, LCD.scrollY, 4),
+    F(0x0405, LCD.line, 4),
+    F(0x0406, LCD.frame, 4),
+    F(0x0407, LCD.lyCompare, 4),
+
+    F(0x0501, LCDC.lcdDisplay, 1),
+    F(0x0502, LCDC.windowTileMap, 1),
+    F(0x0503, LCDC.windowDisplay, 1),
+    F(0x0504, LCDC.tileDataSelect, 1),
+    F(0x0505, LCDC.tileMapSelect, 1),
+    F(0x0506, LCDC.spriteSize, 1),
+    F(0x0507, LCDC.spriteDisplay, 1),
+    F(0x0508, LCDC.bgWindowDisplay, 1),
+
+    F(0x0601, LCDS.lyInterrupt, 1),
+    F(0x0602, LCDS.oamInterrupt, 1),
+    F(0x0603, LCDS.vblankInterrupt, 1),
+    F(0x0604, LCDS.hblankInterrupt, 1),
+    F(0x0605, LCDS.lyFlag, 1),
+    F(0x0606, LCDS.modeFlag, 1),
+
+    F(0x0701, lcdStage.bgp, 1),
+    F(0x0702, lcdStage.obp0, 1),
+    F(0x0703, lcdStage.obp1, 1),
+    F(0x0704, lcdStage.prevLine, 2),
+
+    F(0x0801, inputStage.buttons, 1),
+    F(0x0802, inputStage.select, 1),
+    F(0x0803, inputStage.lines, 1),
+    F(0x0804, inputStage.seen, 1),
+    F(0x0805, inputStage.held, 1),
+    F(0x0806, inputStage.heldOld, 1),
+
+    A(0x0901, vram),
+    A(0x0902, sram),
+    A(0x0903, wram),
+    A(0x0904, oam),
+    A(0x0905, io),
+    A(0x0906, hram),
+};
+
+#define FIELDS  (int)(sizeof(fields) / sizeof(fields[0]))
+
+static void put16(unsigned char *p, unsigned int v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static void put32(unsigned char *p, unsigned int v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static unsigned int get16(const unsigned char *p)
+{
+    return p[0] | p[1] << 8;
+}
+
+static unsigned int get32(const unsigned char *p)
+{
+    return p[0] | p[1] << 8 | p[2] << 16 | (unsigned int)p[3] << 24;
+}
+
+// 内存里size字节的整数（都是无符号或非负的int）
+static unsigned int loadInt(const void *p, int size)
+{
+    switch (size) {
+        case 1: return *(const unsigned char *)p;
+        case 2: return *(const unsigned short *)p;
+        default: return *(const unsigned int *)p;
+    }
+}
+
+static void storeInt(void *p, int size, unsigned int v)
+{
+    switch (size) {
+        case 1: *(unsigned char *)p = v; break;
+        case 2: *(unsigned short *)p = v; break;
+        default: *(unsigned int *)p = v; break;
+    }
+}
+
+static unsigned int fnv1a(const unsigned char *p, long n)
+{
+    unsigned int h = 2166136261u;
+    while (n--) {
+        h ^= *p++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static int fieldBytes(const struct field *f)
+{
+    return f->wire == FIELD_RAW ? f->size : f->wire;
+}
+
+long stateSize(void)
+{
+    long n = STATE_HEADER;
+    for (int i = 0; i < FIELDS; i++) n += 4 + fieldBytes(&fields[i]);
+    return n;
+}
+
+long stateWrite(void *buf, long size)
+{
+    unsigned char *out = buf, *p;
+    long n = stateSize();
+
+    if (size < n) return STATE_ERR_SIZE;
+
+    lcdSaveState(&lcdStage);
+    inputSaveState(&inputStage);
+    memcpy(romStage, &cart[0x134], sizeof(romStage));
+
+    p = out + STATE_HEADER;
+    for (int i = 0; i < FIELDS; i++) {
+        const struct field *f = &fields[i];
+        int len = fieldBytes(f);
+
+        put16(p, f->tag);
+        put16(p + 2, len);
+        p += 4;
+        if (f->wire == FIELD_RAW) {
+            memcpy(p, f->ptr, len);
+        } else {
+            unsigned int v = loadInt(f->ptr, f->size);
+            if (len == 1) *p = v;
+            else if (len == 2) put16(p, v);
+            else put32(p, v);
+        }
+        p += len;
+    }
+
+    memcpy(out, STATE_MAGIC, 4);
+    put16(out + 4, STATE_VERSION);
+    put16(out + 6, 0);
+    put32(out + 8, (unsigned int)(n - STATE_HEADER));
+    put32(out + 12, fnv1a(out + STATE_HEADER, n - STATE_HEADER));
+    return n;
+}
+
+uint64_t stateHashCore(void)
+{
+    unsigned char buf[256], *p = buf;
+
+    lcdGetState(&lcdStage);
+    inputSaveState(&inputStage);
+    for (int i = 0; i < FIELDS; i++) {
+        const struct field *f = &fields[i];
+        unsigned int v;
+
+        if (f->wire == FIELD_RAW) continue;
+        v = loadInt(f->ptr, f->size);
+        if (f->wire == 1) *p = v;
+        else if (f->wire == 2) put16(p, v);
+        else put32(p, v);
+        p += f->wire;
+    }
+    return hash64(buf, p - buf, 0);
+}
+
+static const struct field *findField(unsigned int tag)
+{
+    // 标签按顺序排列，二分查找
+    int lo = 0, hi = FIELDS - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (fields[mid].tag == tag) return &fields[mid];
+        if (fields[mid].tag < tag) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return NULL;
+}
+
+// 走一遍数据：pass 0只检查，pass 1写入
+static int parse(const unsigned char *p, const unsigned char *end, int version, int pass)
+{
+    unsigned char seen[FIELDS];
+
+    memset(seen, 0, sizeof(seen));
+    while (p < end) {
+        const struct field *f;
+        unsigned int tag, len;
+
+        if (end - p < 4) return STATE_ERR_SIZE;
+        tag = get16(p);
+        len = get16(p + 2);
+        p += 4;
+        if ((unsigned long)(end - p) < len) return STATE_ERR_SIZE;
+
+        f = findField(tag);
+        if (f) {
+            if (len != (unsigned int)fieldBytes(f)) return STATE_ERR_FORMAT;
+            seen[f - fields] = 1;
+            if (pass == 0 && f->ptr == romStage && memcmp(p, &cart[0x134], len)) return STATE_ERR_ROM;
+            if (pass == 1 && f->ptr != romStage) {
+                if (f->wire == FIELD_RAW) memcpy(f->ptr, p, len);
+                else storeInt(f->ptr, f->size, len == 1 ? *p : len == 2 ? get16(p) : get32(p));
+            }
+        }
+        p += len;
+    }
+    for (int i = 0; i < FIELDS; i++) {
+        if (!seen[i] && fields[i].since <= version) return STATE_ERR_FORMAT;
+    }
+    return 0;
+}
+
+int stateRead(const void *buf, long size)
+{
+    const unsigned char *in = buf;
+    unsigned int version;
+    long n;
+    int err;
+
+    if (size < STATE_HEADER) return STATE_ERR_SIZE;
+    if (memcmp(in, STATE_MAGIC, 4)) return STATE_ERR_MAGIC;
+    version = get16(in + 4);
+    if (version > STATE_VERSION) return STATE_ERR_VERSION;
+    n = get32(in + 8);
+    if (n > size - STATE_HEADER) return STATE_ERR_SIZE;
+    if (get32(in + 12) != fnv1a(in + STATE_HEADER, n)) return STATE_ERR_CHECKSUM;
+
+    // 先整体检查，通过了才改机器状态
+    err = parse(in + STATE_HEADER, in + STATE_HEADER + n, version, 0);
+    if (err) return err;
+
+    // 以后版本新加的字段不在旧存档里，保持当前值
+    lcdSaveState(&lcdStage);
+    inputSaveState(&inputStage);
+    parse(in + STATE_HEADER, in + STATE_HEADER + n, version, 1);
+    memTouchAll();
+    lcdStage.serial = 0;
+    lcdLoadState(&lcdStage);
+    inputLoadState(&inputStage);
+    return 0;
+}
@@ -0,0 +1,76 @@
+//
+//  state.h
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+#ifndef state_h
+#define state_h
+
+#include <stdint.h>
+
+#include "cpu.h"
+#include "input.h"
+#include "interrupt.h"
+#include "lcd.h"
+#include "timer.h"
+
+// 内存数组以外的状态（寄存器、各部件内部状态），几百字节
+struct machineCore {
+    struct registers registers;
+    struct interrupt interrupt;
+    struct timer timer;
+    struct LCD LCD;
+    struct LCDC LCDC;
+    struct LCDS LCDS;
+    struct lcdState lcd;
+    struct inputState input;
+};
+
+// 整台机器的快照（约25KB），调用者提供存储，存取都不分配内存
+struct machineState {
+    struct machineCore core;
+    unsigned char vram[0x2000];
+    unsigned char sram[0x2000];
+    unsigned char wram[0x2000];
+    unsigned char oam[0x100];
+    unsigned char io[0x100];
+    unsigned char hram[0x80];
+};
+
+// 只在模拟线程、帧之间调用
+void stateSave(struct machineState *state);
+void stateLoad(const struct machineState *state);
+void stateSaveCore(struct machineCore *core);
+void stateLoadCore(const struct machineCore *core);
+
+/*
+ 存档文件格式（小端）：
+   头 16字节: "VGBS" | u16 版本 | u16 0 | u32 数据长度 | u32 数据的FNV-1a
+   数据: 若干个 u16 标签 | u16 长度 | 内容
+ 标签高字节是分组，低字节是字段；读档跳过不认识的标签，本版本已有的字段缺一不可。
+ 改字段的含义要换新标签，只加字段时不用升版本。
+ */
+#define STATE_MAGIC     "VGBS"
+#define STATE_VERSION   1
+#define STATE_HEADER    16
+
+#define STATE_ERR_SIZE      (-1)    // 缓冲不够或数据被截断
+#define STATE_ERR_MAGIC     (-2)
+#define STATE_ERR_VERSION   (-3)    // 比本程序新
+#define STATE_ERR_CHECKSUM  (-4)
+#define STATE_ERR_FORMAT    (-5)    // 字段长度不对或缺字段
+#define STATE_ERR_ROM       (-6)    // 不是当前卡带的存档
+
+// 存档的字节数（固定）
+long stateSize(void);
+// 写入buf，返回写入的字节数或STATE_ERR_SIZE；读档成功返回0，失败时机器状态不变
+long stateWrite(void *buf, long size);
+int stateRead(const void *buf, long size);
+
+// 内存数组以外的状态按存档的字段和宽度算hash64，和结构体布局无关，不算一次存档
+uint64_t stateHashCore(void);
+
+#endif /* state_h */
@@ -74,16 +74,14 @@ void tick(void)
 
 void timerCycle(void)
 {
-    static unsigned int time = 0;
-    static unsigned int change = 0;
-    unsigned int delta = getCycles() - time;
-    time = getCycles();
+    unsigned int delta = getCycles() - timer.last;
+    timer.last = getCycles();
 
-    change += delta * 4;
+    timer.change += delta * 4;
 
-    if (change >= 16) {
+    if (timer.change >= 16) {
         tick();
-        change -= 16;
+        timer.change -= 16;
     }
 }
 
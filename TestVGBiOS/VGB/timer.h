@@ -1,3 +1,6 @@
+#ifndef timer_h
+#define timer_h
+
 struct timer {
     unsigned int div;   // divider
     unsigned int tima;  // timer counter
@@ -6,6 +9,8 @@ struct timer {
     unsigned int speed;
     unsigned int started; 
     unsigned int tick;
+    unsigned int last;  // 上次timerCycle时的cpu周期
+    unsigned int change;// 还没换成tick的时钟数
 };
 
 extern struct timer timer;
@@ -22,3 +27,5 @@ unsigned int getTac(void);
 
 void tick(void);
 void timerCycle(void);
+
+#endif /* timer_h */
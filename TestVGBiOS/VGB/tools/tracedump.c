@@ -0,0 +1,129 @@
+//
+//  tracedump.c
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+/*
+ 把trace.h格式的执行轨迹还原成文本：
+   cc -I. tools/tracedump.c profile.c -o tracedump
+   ./tracedump [-d] [-n 条数] trace.bin
+ 默认每条指令一行，带反汇编和寄存器；-d输出gameboy-doctor的格式
+ （A:01 F:B0 ... SP:FFFE PC:0100 PCMEM:00,C3,13,02），不含中断记录，可以直接
+ 和其他模拟器的日志diff。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "profile.h"
+#include "trace.h"
+
+static unsigned int get16(const unsigned char *p)
+{
+    return p[0] | p[1] << 8;
+}
+
+static unsigned int get32(const unsigned char *p)
+{
+    return get16(p) | get16(p + 2) << 16;
+}
+
+// 每种指令的长度（字节）
+static int length(const unsigned char *m)
+{
+    static const unsigned char imm8[] = {
+        0x06, 0x0E, 0x10, 0x16, 0x18, 0x1E, 0x20, 0x26, 0x28, 0x2E, 0x30, 0x36, 0x38, 0x3E,
+        0xC6, 0xCB, 0xCE, 0xD6, 0xDE, 0xE0, 0xE6, 0xE8, 0xEE, 0xF0, 0xF6, 0xF8, 0xFE,
+    };
+    static const unsigned char imm16[] = {
+        0x01, 0x08, 0x11, 0x21, 0x31, 0xC2, 0xC3, 0xC4, 0xCA, 0xCC, 0xCD, 0xD2, 0xD4, 0xDA, 0xDC, 0xEA, 0xFA,
+    };
+
+    if (memchr(imm16, m[0], sizeof(imm16))) return 3;
+    if (memchr(imm8, m[0], sizeof(imm8))) return 2;
+    return 1;
+}
+
+// 把名字里的n、nn、e换成操作数
+static void disassemble(unsigned int pc, const unsigned char *m, char *out)
+{
+    char name[16];
+    const char *p;
+    unsigned int op = m[0] == 0xCB ? PROFILE_CB + m[1] : m[0];
+
+    profileOpName(op, name);
+    for (p = name; *p; p++) {
+        int start = p == name || !((p[-1] >= 'a' && p[-1] <= 'z') || (p[-1] >= 'A' && p[-1] <= 'Z'));
+        if (start && p[0] == 'n' && p[1] == 'n') {
+            out += sprintf(out, "$%04X", m[1] | m[2] << 8);
+            p++;
+        } else if (start && p[0] == 'n') {
+            out += sprintf(out, "$%02X", m[1]);
+        } else if (start && p[0] == 'e') {
+            if (m[0] == 0xE8 || m[0] == 0xF8) out += sprintf(out, "%d", (signed char)m[1]);
+            else out += sprintf(out, "$%04X", (pc + 2 + (signed char)m[1]) & 0xFFFF);
+        } else {
+            *out++ = *p;
+        }
+    }
+    *out = 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = NULL;
+    unsigned char header[TRACE_HEADER], r[TRACE_RECORD];
+    unsigned long long n = 0, limit = ~0ULL;
+    int doctor = 0;
+    FILE *f;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-d")) doctor = 1;
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc) limit = strtoull(argv[++i], NULL, 10);
+        else path = argv[i];
+    }
+    if (!path) {
+        fprintf(stderr, "usage: %s [-d] [-n records] trace.bin\n", argv[0]);
+        return 1;
+    }
+    f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    if (fread(header, 1, sizeof(header), f) != sizeof(header) || memcmp(header, TRACE_MAGIC, 4) ||
+        get16(header + 4) > TRACE_VERSION || get16(header + 6) != TRACE_RECORD) {
+        fprintf(stderr, "%s: not a trace\n", path);
+        fclose(f);
+        return 1;
+    }
+    if (!doctor) printf("# rom %08x%08x\n", get32(header + 12), get32(header + 8));
+
+    while (n < limit && fread(r, 1, sizeof(r), f) == sizeof(r)) {
+        unsigned int cycles = get32(r), pc = get16(r + 4), sp = get16(r + 6);
+        const unsigned char *m = r + 16;
+        char text[32], bytes[10];
+
+        n++;
+        if (doctor) {
+            if (r[20] != TRACE_INSTRUCTION) continue;
+            printf("A:%02X F:%02X B:%02X C:%02X D:%02X E:%02X H:%02X L:%02X SP:%04X PC:%04X PCMEM:%02X,%02X,%02X,%02X\n",
+                   r[8], r[9], r[10], r[11], r[12], r[13], r[14], r[15], sp, pc, m[0], m[1], m[2], m[3]);
+            continue;
+        }
+        if (r[20] == TRACE_INTERRUPT) {
+            printf("%10u %04X: --       interrupt        SP=%04X IME=%d IE=%02X IF=%02X\n", cycles, pc, sp, r[21], r[22], r[23]);
+            continue;
+        }
+        disassemble(pc, m, text);
+        for (int i = 0, k = length(m); i < 3; i++) sprintf(bytes + i * 3, i < k ? "%02X " : "   ", m[i]);
+        printf("%10u %04X: %s %-16s A=%02X F=%02X BC=%02X%02X DE=%02X%02X HL=%02X%02X SP=%04X IME=%d IE=%02X IF=%02X\n",
+               cycles, pc, bytes, text, r[8], r[9], r[10], r[11], r[12], r[13], r[14], r[15], sp, r[21], r[22], r[23]);
+    }
+    fclose(f);
+    return 0;
+}
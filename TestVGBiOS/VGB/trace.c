@@ -0,0 +1,231 @@
+//
+//  trace.c
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+/*
+ 模拟线程把记录写进一个单生产者单消费者的无锁环，写盘线程每隔1ms把攒下的
+ 一段fwrite出去。生产者只写head、消费者只写tail，各自用release发布、acquire
+ 读对方的。环满时生产者让出CPU等写盘线程（记下stalls），不丢记录。
+ */
+
+#include "trace.h"
+
+#ifdef VGB_TRACE
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cpu.h"
+#include "hash.h"
+#include "interrupt.h"
+#include "mmu.h"
+
+#define RING    (1 << 18)   // 记录数，6MB
+
+extern struct registers registers;
+
+static unsigned char *ring;
+static atomic_ulong head, tail;
+static atomic_int stopping;
+static unsigned long local;     // 生产者的head
+static unsigned long seenTail;  // 生产者上次读到的tail
+static FILE *file;
+static pthread_t writer;
+static int active;
+
+static struct traceStats stats;
+static atomic_ulong writes;
+
+static void put16(unsigned char *p, unsigned int v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static void put32(unsigned char *p, unsigned int v)
+{
+    put16(p, v);
+    put16(p + 2, v >> 16);
+}
+
+static void *writeLoop(void *arg)
+{
+    struct timespec ms = { 0, 1000000 };
+    unsigned long t = atomic_load_explicit(&tail, memory_order_relaxed);
+
+    (void)arg;
+
+    while (1) {
+        int stop = atomic_load_explicit(&stopping, memory_order_acquire);
+        unsigned long h = atomic_load_explicit(&head, memory_order_acquire);
+        unsigned long first, n;
+
+        if (h == t) {
+            if (stop) break;
+            nanosleep(&ms, NULL);
+            continue;
+        }
+        first = t % RING;
+        n = h - t;
+        if (n > RING - first) n = RING - first;
+        fwrite(ring + first * TRACE_RECORD, TRACE_RECORD, n, file);
+        t += n;
+        atomic_store_explicit(&tail, t, memory_order_release);
+        atomic_fetch_add_explicit(&writes, 1, memory_order_relaxed);
+    }
+    return NULL;
+}
+
+int traceStart(const char *path)
+{
+    unsigned char header[TRACE_HEADER];
+    uint64_t rom = hash64(cart, 0x8000, 0);
+
+    traceStop();
+    ring = malloc((size_t)RING * TRACE_RECORD);
+    if (!ring) return -1;
+    file = fopen(path, "wb");
+    if (!file) {
+        free(ring);
+        ring = NULL;
+        return -1;
+    }
+    memcpy(header, TRACE_MAGIC, 4);
+    put16(header + 4, TRACE_VERSION);
+    put16(header + 6, TRACE_RECORD);
+    put32(header + 8, (unsigned int)rom);
+    put32(header + 12, (unsigned int)(rom >> 32));
+    fwrite(header, 1, sizeof(header), file);
+
+    local = seenTail = 0;
+    atomic_store(&head, 0);
+    atomic_store(&tail, 0);
+    atomic_store(&stopping, 0);
+    atomic_store(&writes, 0);
+    memset(&stats, 0, sizeof(stats));
+    if (pthread_create(&writer, NULL, writeLoop, NULL) != 0) {
+        fclose(file);
+        free(ring);
+        ring = NULL;
+        return -1;
+    }
+    active = 1;
+    return 0;
+}
+
+void traceStop(void)
+{
+    if (!active) return;
+    active = 0;
+    atomic_store_explicit(&stopping, 1, memory_order_release);
+    pthread_join(writer, NULL);
+    fclose(file);
+    free(ring);
+    ring = NULL;
+    stats.writes = atomic_load(&writes);
+}
+
+int traceActive(void)
+{
+    return active;
+}
+
+// 不走read8：不算进VGB_STATS的计数；I/O寄存器读了有副作用（比如FF00），不去读
+static unsigned char peek(unsigned short address)
+{
+    return address >= 0xFF00 && address < 0xFF80 ? 0 : peek8(address);
+}
+
+static void record(int type)
+{
+    unsigned char *p;
+    unsigned short pc = registers.PC;
+
+    if (local - seenTail >= RING) {
+        seenTail = atomic_load_explicit(&tail, memory_order_acquire);
+        while (local - seenTail >= RING) {
+            stats.stalls++;
+            sched_yield();
+            seenTail = atomic_load_explicit(&tail, memory_order_acquire);
+        }
+    }
+    p = ring + (local % RING) * TRACE_RECORD;
+    put32(p, registers.cycles);
+    put16(p + 4, pc);
+    put16(p + 6, registers.SP);
+    p[8] = registers.A;
+    p[9] = registers.F;
+    p[10] = registers.B;
+    p[11] = registers.C;
+    p[12] = registers.D;
+    p[13] = registers.E;
+    p[14] = registers.H;
+    p[15] = registers.L;
+    for (int i = 0; i < 4; i++) p[16 + i] = peek(pc + i);
+    p[20] = type;
+    p[21] = interrupt.master;
+    p[22] = interrupt.enable;
+    p[23] = interrupt.flags;
+    local++;
+    atomic_store_explicit(&head, local, memory_order_release);
+    stats.records++;
+}
+
+void traceInstruction(void)
+{
+    if (active) record(TRACE_INSTRUCTION);
+}
+
+void traceInterrupt(unsigned short address)
+{
+    (void)address;//调用时PC已经是向量地址，记录里就是它
+    if (active) record(TRACE_INTERRUPT);
+}
+
+void traceGetStats(struct traceStats *s)
+{
+    *s = stats;
+    s->writes = atomic_load(&writes);
+}
+
+#else
+
+int traceStart(const char *path)
+{
+    (void)path;
+    return -1;
+}
+
+void traceStop(void)
+{
+}
+
+int traceActive(void)
+{
+    return 0;
+}
+
+void traceInstruction(void)
+{
+}
+
+void traceInterrupt(unsigned short address)
+{
+    (void)address;
+}
+
+void traceGetStats(struct traceStats *s)
+{
+    s->records = s->stalls = s->writes = 0;
+}
+
+#endif
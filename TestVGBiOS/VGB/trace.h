@@ -0,0 +1,46 @@
+//
+//  trace.h
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+#ifndef trace_h
+#define trace_h
+
+/*
+ 执行轨迹文件格式（小端），编译时定义VGB_TRACE才有：
+   头 16字节: "VGBT" | u16 版本 | u16 记录长度 | u64 ROM哈希
+   记录 24字节 x N:
+     u32 周期 | u16 PC | u16 SP | u8 A F B C D E H L | u8 PC处的4个字节 |
+     u8 类型 | u8 IME | u8 IE | u8 IF
+ 指令记录是取指之前的状态；中断记录是跳到中断向量之后（PC为向量，SP已压栈）。
+ HALT期间没有记录。tools/tracedump.c把它还原成文本。
+ */
+#define TRACE_MAGIC         "VGBT"
+#define TRACE_VERSION       1
+#define TRACE_HEADER        16
+#define TRACE_RECORD        24
+
+#define TRACE_INSTRUCTION   0
+#define TRACE_INTERRUPT     1
+
+struct traceStats {
+    unsigned long long records;
+    unsigned long long stalls;      // 环满了，模拟线程等写盘线程的次数
+    unsigned long long writes;      // 写盘线程fwrite的次数
+};
+
+// 只在模拟线程调用。没有编译进来时traceStart返回-1
+int traceStart(const char *path);
+void traceStop(void);               // 等剩下的记录写完，关闭文件
+int traceActive(void);
+
+// cpu.c的钩子
+void traceInstruction(void);
+void traceInterrupt(unsigned short address);
+
+void traceGetStats(struct traceStats *stats);
+
+#endif /* trace_h */
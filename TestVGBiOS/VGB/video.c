@@ -0,0 +1,159 @@
+//
+//  video.c
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+/*
+ lcd只输出8位索引像素（见lcd.h中的PIX_*），这里在呈现时才查表转换成RGB。
+ 索引的低2位是色阶，每个输出字节都是色阶的函数，因此可以用一次16字节查表
+ 指令（SSSE3 pshufb / NEON tbl）同时处理16个像素。
+ */
+
+#include "video.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "lcd.h"
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define VIDEO_NEON 1
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define VIDEO_SSSE3 1
+#endif
+
+extern unsigned int colours[4];
+
+static struct videoTarget target;
+
+int videoBytesPerPixel(int format)
+{
+    if (format == VIDEO_GREY8) return 1;
+    return format == VIDEO_RGB565 ? 2 : 4;
+}
+
+void videoSetTarget(void *pixels, int stride, int format)
+{
+    target.pixels = pixels;
+    target.stride = stride;
+    target.format = format;
+    lcdInvalidate();
+}
+
+const struct videoTarget* videoGetTarget(void)
+{
+    return &target;
+}
+
+void videoLine(const unsigned char *src, int line)
+{
+    if (!target.pixels) return;
+    videoConvert(src, target.pixels + (long)line*target.stride, target.format, 160);
+}
+
+// 生成每个输出字节的查表：tab[b][shade]为第b个字节
+static int buildTables(int format, uint8_t tab[4][16])
+{
+    memset(tab, 0, 4*16);
+    for (int i = 0; i < 4; i++) {
+        uint8_t r = (colours[i] >> 16) & 0xFF;
+        uint8_t g = (colours[i] >> 8) & 0xFF;
+        uint8_t b = colours[i] & 0xFF;
+        uint16_t c565 = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+        uint8_t y = (r*299 + g*587 + b*114) / 1000;
+        
+        switch (format) {
+            case VIDEO_RGBA8888:
+                tab[0][i] = r; tab[1][i] = g; tab[2][i] = b; tab[3][i] = 0xFF;
+                break;
+            case VIDEO_BGRA8888:
+                tab[0][i] = b; tab[1][i] = g; tab[2][i] = r; tab[3][i] = 0xFF;
+                break;
+            case VIDEO_RGB565:
+                tab[0][i] = c565 & 0xFF; tab[1][i] = c565 >> 8;
+                break;
+            case VIDEO_GREY8:
+                tab[0][i] = y;
+                break;
+        }
+    }
+    return videoBytesPerPixel(format);
+}
+
+void videoConvert(const unsigned char *src, void *dst, int format, int count)
+{
+    uint8_t tab[4][16];
+    int bpp = buildTables(format, tab);
+    uint8_t *out = dst;
+    int i = 0;
+    
+#if VIDEO_NEON
+    uint8x16_t t0 = vld1q_u8(tab[0]), t1 = vld1q_u8(tab[1]);
+    uint8x16_t t2 = vld1q_u8(tab[2]), t3 = vld1q_u8(tab[3]);
+    uint8x16_t m = vdupq_n_u8(0x03);
+    
+    for (; i + 16 <= count; i += 16) {
+        uint8x16_t s = vandq_u8(vld1q_u8(src + i), m);
+        if (bpp == 4) {
+            uint8x16x4_t px;
+            px.val[0] = vqtbl1q_u8(t0, s);
+            px.val[1] = vqtbl1q_u8(t1, s);
+            px.val[2] = vqtbl1q_u8(t2, s);
+            px.val[3] = vqtbl1q_u8(t3, s);
+            vst4q_u8(out + i*4, px);
+        } else if (bpp == 1) {
+            vst1q_u8(out + i, vqtbl1q_u8(t0, s));
+        } else {
+            uint8x16x2_t px;
+            px.val[0] = vqtbl1q_u8(t0, s);
+            px.val[1] = vqtbl1q_u8(t1, s);
+            vst2q_u8(out + i*2, px);
+        }
+    }
+#elif VIDEO_SSSE3
+    __m128i t0 = _mm_loadu_si128((const __m128i*)tab[0]), t1 = _mm_loadu_si128((const __m128i*)tab[1]);
+    __m128i t2 = _mm_loadu_si128((const __m128i*)tab[2]), t3 = _mm_loadu_si128((const __m128i*)tab[3]);
+    __m128i m = _mm_set1_epi8(0x03);
+    
+    for (; i + 16 <= count; i += 16) {
+        __m128i s = _mm_and_si128(_mm_loadu_si128((const __m128i*)(src + i)), m);
+        __m128i c0 = _mm_shuffle_epi8(t0, s);
+        __m128i c1 = _mm_shuffle_epi8(t1, s);
+        if (bpp == 1) {
+            _mm_storeu_si128((__m128i*)(out + i), c0);
+        } else if (bpp == 4) {
+            __m128i c2 = _mm_shuffle_epi8(t2, s);
+            __m128i c3 = _mm_shuffle_epi8(t3, s);
+            __m128i lo01 = _mm_unpacklo_epi8(c0, c1), hi01 = _mm_unpackhi_epi8(c0, c1);
+            __m128i lo23 = _mm_unpacklo_epi8(c2, c3), hi23 = _mm_unpackhi_epi8(c2, c3);
+            __m128i *o = (__m128i*)(out + i*4);
+            _mm_storeu_si128(o + 0, _mm_unpacklo_epi16(lo01, lo23));
+            _mm_storeu_si128(o + 1, _mm_unpackhi_epi16(lo01, lo23));
+            _mm_storeu_si128(o + 2, _mm_unpacklo_epi16(hi01, hi23));
+            _mm_storeu_si128(o + 3, _mm_unpackhi_epi16(hi01, hi23));
+        } else {
+            __m128i *o = (__m128i*)(out + i*2);
+            _mm_storeu_si128(o + 0, _mm_unpacklo_epi8(c0, c1));
+            _mm_storeu_si128(o + 1, _mm_unpackhi_epi8(c0, c1));
+        }
+    }
+#endif
+    
+    // 剩余像素（或无SIMD时全部像素）逐个查表
+    if (bpp == 4) {
+        uint32_t lut[4];
+        for (int c = 0; c < 4; c++) memcpy(&lut[c], (uint8_t[4]){tab[0][c], tab[1][c], tab[2][c], tab[3][c]}, 4);
+        for (; i < count; i++) memcpy(out + i*4, &lut[src[i] & 0x03], 4);
+    } else if (bpp == 1) {
+        for (; i < count; i++) out[i] = tab[0][src[i] & 0x03];
+    } else {
+        uint16_t lut[4];
+        for (int c = 0; c < 4; c++) memcpy(&lut[c], (uint8_t[2]){tab[0][c], tab[1][c]}, 2);
+        for (; i < count; i++) memcpy(out + i*2, &lut[src[i] & 0x03], 2);
+    }
+}
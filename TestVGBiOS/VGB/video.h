@@ -0,0 +1,35 @@
+//
+//  video.h
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+#ifndef video_h
+#define video_h
+
+// 输出像素格式（按内存字节顺序命名）
+#define VIDEO_RGBA8888  0
+#define VIDEO_BGRA8888  1
+#define VIDEO_RGB565    2
+#define VIDEO_GREY8     3
+
+// 宿主提供的输出缓冲，lcd每渲染完一行就直接转换写入对应行
+struct videoTarget {
+    unsigned char *pixels;
+    int stride; // 每行字节数，可以为负（自下而上的缓冲）
+    int format;
+};
+
+int videoBytesPerPixel(int format);
+
+// 设置输出缓冲，之后所有行都会重新渲染一次；pixels为NULL时不输出
+void videoSetTarget(void *pixels, int stride, int format);
+const struct videoTarget* videoGetTarget(void);
+void videoLine(const unsigned char *src, int line);
+
+// 把lcd的索引帧缓冲转换为目标格式，count为像素个数
+void videoConvert(const unsigned char *src, void *dst, int format, int count);
+
+#endif /* video_h */
@@ -25,30 +25,125 @@ Sound        - 4 channels with stereo sound
 Power        - DC6V 0.7W (DC3V 0.7W for GB Pocket, DC3V 0.6W for CGB)
 */
 
+#include "vmain.h"
+
 #include <stdio.h>
+#include <stdint.h>
 
 #include "lcd.h"
 #include "rom.h"
 #include "interrupt.h"
 #include "timer.h"
 #include "cpu.h"
+#include "input.h"
+#include "rewind.h"
+#include "state.h"
 
 int wnd_init(const char *filename);
+void wnd_draw(uint8_t* pixels);
+int wnd_updateEvent(void);
+
+static volatile int runAhead;
+static volatile int rewinding;
+static struct machineState snapshot;
+
+void vmainSetRunAhead(int frames)
+{
+    runAhead = frames < 0 ? 0 : frames > RUNAHEAD_MAX ? RUNAHEAD_MAX : frames;
+}
+
+int vmainGetRunAhead(void)
+{
+    return runAhead;
+}
+
+void vmainSetRewind(int on)
+{
+    rewinding = on;
+}
+
+// 跑到下一次进入VBlank
+static void runFrame(void)
+{
+    do {
+        // 组件执行循环
+        cpuCycle();
+        inputCycle();
+        interruptCycle();
+        timerCycle();
+    } while (!lcdCycle());
+}
+
+/*
+ 超前运行：真实的一帧不渲染；到VBlank时存档，带着当前输入再跑ahead帧，只渲染
+ 并呈现最后一帧，然后读档回到真实的时间线，取走新的输入接着跑下一帧真实的。
+ 画面比真实硬件早ahead帧，游戏对输入的反应也就早ahead帧被看到。
+ */
+static void frameAhead(int ahead, int wasAhead)
+{
+    int skip;
+    
+    lcdFrameEnd();
+    skip = lcdFrameSkipped();
+    if (!wasAhead) lcdInvalidate();//上一帧渲染了但没有呈现，整帧重画
+    stateSave(&snapshot);
+    inputSetAhead(1);
+    for (int i = 0; i < ahead; i++) {
+        lcdSkipFrame(skip || i < ahead - 1);
+        runFrame();
+        if (i == ahead - 1) wnd_draw(NULL);
+        lcdFrameEnd();
+    }
+    inputSetAhead(0);
+    stateLoad(&snapshot);
+    lcdSkipFrame(1);
+    inputFrame();//和不超前时一样，宿主等待之后取输入，从下一帧真实的开始生效
+}
+
+/*
+ 倒带：读回一个快照，从那里渲染一帧呈现出来。快照存在VBlank，所以画面是它
+ 的下一帧；倒带时的按键不生效。倒到最老的快照后停在那里。
+ */
+static void frameRewind(void)
+{
+    if (rewindStep()) {
+        lcdSkipFrame(0);
+        runFrame();
+    }
+    wnd_draw(NULL);
+    lcdFrameEnd();
+    inputFrame();
+}
 
 int vmain(int argc, const char* argv)
 {
+    int wasAhead = 0;
     
     // 组件初始化
     romInit(argv);
     cpuInit();
+    inputInit();
     wnd_init("");
     
     while (1) {
-        // 组件执行循环
-        cpuCycle();
-        interruptCycle();
-        timerCycle();
-        if (!lcdCycle()) break;
+        int ahead = runAhead;
+        
+        if (rewinding) {
+            frameRewind();
+            ahead = 0;
+        } else {
+            runFrame();
+            rewindFrame();
+            if (ahead) {
+                frameAhead(ahead, wasAhead);
+            } else {
+                wnd_draw(NULL);
+                lcdFrameEnd();//先结束这一帧，和超前时一样，录像核对的状态才一致
+                inputFrame();//宿主等待之后，下一帧从这里开始
+            }
+        }
+        wasAhead = ahead;
+        if (wnd_updateEvent()) break;
     }
     
     // 组件退出清理
@@ -0,0 +1,23 @@
+//
+//  vmain.h
+//  TestVGB
+//
+//  Created by vin on 2026/10/19.
+//  Copyright © 2026年 vin. All rights reserved.
+//
+
+#ifndef vmain_h
+#define vmain_h
+
+#define RUNAHEAD_MAX    4
+
+int vmain(int argc, const char* argv);
+
+// 超前运行的帧数(0关闭)，每帧多模拟frames帧，可以在任意线程调用，下一帧生效
+void vmainSetRunAhead(int frames);
+int vmainGetRunAhead(void);
+
+// 倒带：打开时每帧倒回一个快照（要先rewindInit），任意线程调用
+void vmainSetRewind(int on);
+
+#endif /* vmain_h */
@@ -10,33 +10,57 @@
 
 int vmain(int argc, const char* argv);
 void wnd_key2btn(int key, char isDown);
+void wnd_displayTick(void);
+CGImageRef wnd_frontImage(void);
 
 @interface ViewController ()
 
 @property (weak, nonatomic) IBOutlet UIImageView *canvasImageView;
 @property (weak, nonatomic) IBOutlet UILabel *fpsLabel;
+@property (strong, nonatomic) CADisplayLink *displayLink;
 
 @end
 
 @implementation ViewController
 
-- (void)dealloc
-{
-    [[NSNotificationCenter defaultCenter] removeObserver:self];
-}
-
 - (void)viewDidLoad {
     [super viewDidLoad];
     // Do any additional setup after loading the view, typically from a nib.
     
-    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(video:) name:@"gb_video" object:nil];
-    
     dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
         NSString* path = [[NSBundle mainBundle] pathForResource:@"Tetris" ofType:@"gb"];
         vmain((int)path.length, [path UTF8String]);
     });
 }
 
+- (void)viewWillAppear:(BOOL)animated {
+    [super viewWillAppear:animated];
+    
+    //屏幕刷新节拍：取最新帧，也供PACE_DISPLAY模式使用
+    //displayLink持有self，所以在消失时invalidate，不能等dealloc
+    _displayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(displayTick:)];
+    [_displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+}
+
+- (void)viewWillDisappear:(BOOL)animated {
+    [super viewWillDisappear:animated];
+    
+    [_displayLink invalidate];
+    _displayLink = nil;
+}
+
+- (void)displayTick:(CADisplayLink*)link
+{
+    wnd_displayTick();
+    
+    //没有新帧时保持上一帧
+    CGImageRef image = wnd_frontImage();
+    if (image) {
+        [self calcFPS];
+        _canvasImageView.layer.contents = (__bridge id)image;
+        CGImageRelease(image);
+    }
+}
 
 - (void)didReceiveMemoryWarning {
     [super didReceiveMemoryWarning];
@@ -65,26 +89,13 @@ double time0 = 0; uint8_t fpsArr[100]; uint16_t len = 0;
     }
 }
 
-- (void)video:(NSNotification*)n
-{
-    //子线程
-    [self calcFPS];
-    UIImage* image = [n.userInfo objectForKey:@"video"];
-    dispatch_async(dispatch_get_main_queue(), ^{
-        self->_canvasImageView.image = nil;
-        self->_canvasImageView.image = image;
-    });
-}
-
 - (IBAction)btnDown:(id)sender {
     NSInteger tag = ((UIButton*)sender).tag;
     wnd_key2btn((int)tag, YES);
 }
 - (IBAction)btnUp:(id)sender {
     NSInteger tag = ((UIButton*)sender).tag;
-    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.1 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^(void){
-        wnd_key2btn((int)tag, NO);
-    });
+    wnd_key2btn((int)tag, NO);//游戏读到按下之前松开会被推迟(input.c)
 }
 
 @end